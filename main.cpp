@@ -8,11 +8,90 @@
 
 #include "FEHLCD.h"
 #include "FEHUtility.h"
+#include "FEHSD.h"
 #include <string>
 #include <vector>
+#include <algorithm>
 #include <cstdlib>
+#include <cstdint>
 #include <ctime>
 
+// -DMINIMON_AUTOMATION (host only) runs a scripted UI session on the virtual clock
+#ifdef MINIMON_AUTOMATION
+#define MINIMON_VIRTUAL_CLOCK
+#endif
+#if defined(MINIMON_VIRTUAL_CLOCK) || defined(MINIMON_FUZZ)
+#include <cstdio>
+#endif
+#if defined(MINIMON_AUTOMATION) || defined(MINIMON_FUZZ) || defined(MINIMON_PROFILE) || defined(MINIMON_BENCH) || \
+    defined(MINIMON_SIM) || defined(MINIMON_BROADCAST) || defined(MINIMON_VIEWER)
+#include <cstring>
+#endif
+// -DMINIMON_BALANCE (host only) prints the balance report for the bank instead of running the game
+#ifdef MINIMON_BALANCE
+#include <cstdio>
+#include <chrono>
+#include <functional>
+#include <thread>
+#endif
+// -DMINIMON_SIM (host only, POSIX) runs the multi-process balance simulator instead of the game
+#ifdef MINIMON_SIM
+#include <cstdio>
+#include <atomic>
+#include <new>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+#endif
+// -DMINIMON_BROADCAST (host, POSIX) mirrors the game to spectators; -DMINIMON_VIEWER builds a spectator
+#if defined(MINIMON_BROADCAST) || defined(MINIMON_VIEWER)
+#include <cerrno>
+#include <cstdio>
+#include <memory>
+#include <deque>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#endif
+// POSIX hosts dump the flight recorder on fatal signals
+#if defined(__unix__) || defined(__APPLE__)
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+// -DMINIMON_PROFILE (host only, POSIX) turns on the sampling profiler; link with -rdynamic for symbol names
+#ifdef MINIMON_PROFILE
+#include <cstdio>
+#include <csignal>
+#include <sys/time.h>
+#include <execinfo.h>
+#include <cxxabi.h>
+#include <map>
+#endif
+// -DMINIMON_BENCH (host only) runs the micro-benchmarks instead of the game; counters need Linux
+#ifdef MINIMON_BENCH
+#include <cstdio>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+#endif
+
 using namespace std;
 
 // ----------------------------- CONSTANTS -----------------------------
@@ -43,707 +122,5123 @@ const int STATUS_TEXT_H = 44;
 // Gameplay constants
 const int RETREAT_HEAL = 8;
 const int MIN_DAMAGE = 1;
+const int DAMAGE_ROLL_MIN = 85;     // damage multiplier roll range (percent)
+const int DAMAGE_ROLL_MAX = 100;
 const int PROJECTILE_SPEED_MS = 20; // sleep between projectile steps
 const int PROJECTILE_STEP_PX = 6;   // pixels per step
 const int BUTTON_DEBOUNCE_MS = 120;
 const int RESULT_PAUSE_MS = 1100;
 
+// Session checkpoint file (written after every match, read back at startup)
+const char* CHECKPOINT_FILE = "minimon.ckp";
+const int CHECKPOINT_VERSION = 2;
+
+// Matchup matrix cache (balance tooling): cells are keyed by species content hashes
+const char* MATCHUP_CACHE_FILE = "matchups.dat";
+const int MATCHUP_HITS = 3; // matrix cell = chance to KO within this many uses of the best move
 
 
+// ----------------------------- GAME PHASES -----------------------------
+// What the game is doing right now. Cheap enough to keep in every build; the profiler tags its
+// samples with it and so does the flight recorder.
+enum GamePhase { PHASE_MENU, PHASE_BATTLE, PHASE_CPU, PHASE_PROJECTILE, PHASE_DAMAGE, PHASE_RESULT, NUM_PHASES };
+const char* PHASE_NAMES[NUM_PHASES] = { "menu", "battle", "cpu_decision", "projectile_frame", "damage", "result_screen" };
+volatile int gamePhase = PHASE_MENU; // volatile: read from the profiler's signal handler
+uint16_t framePhaseRuns[NUM_PHASES];  // phases entered since the last frame, for the frame watchdog
+
 /*
-    Function: SleepMs
-    Inputs: int ms - milliseconds to sleep
-    Returns: void
-    Purpose: Sleep can either take input in ms or s; this ensures ms usage throughout the project
-    Author: Pranav Rajesh
+    Class: PhaseScope
+    Members:
+      - int saved : phase to restore when the scope ends
+    Purpose: Set gamePhase for the lifetime of a block, so nested phases unwind correctly.
 */
-void SleepMs(int ms) 
-{ 
-    Sleep(ms); 
-}
+struct PhaseScope {
+    int saved;
+    explicit PhaseScope(int phase) : saved(gamePhase) { gamePhase = phase; framePhaseRuns[phase]++; }
+    ~PhaseScope() { gamePhase = saved; }
+};
+
+// ----------------------------- FLIGHT RECORDER -----------------------------
+// Always-on postmortem log: the last FLIGHT_EVENTS events (touches, actions, rolls, damage, frame
+// times) in a fixed ring of 12-byte records. Recording is an index increment and a few stores, so it
+// stays enabled in every build. flightDump writes the ring to storage on request, on a watchdog
+// trigger or (host builds) on a fatal signal. Events are stamped with the last clock reading (NowMs
+// keeps it in flightClockMs) instead of reading the clock again: TimeNow is a double on a soft-float device.
+const int FLIGHT_EVENTS = 256; // power of two, so wrapping is a mask
+const char* FLIGHT_FILE = "flight.log";
+uint32_t flightClockMs = 0; // the last NowMs() reading, truncated
+long long NowMs();
+
+enum FlightEventType { FR_TOUCH, FR_ACTION, FR_ROLL, FR_DAMAGE, FR_FRAME, FR_MATCH, FR_WATCHDOG, FR_DRAWS, FR_PHASE_RUNS,
+                       NUM_FLIGHT_TYPES };
+const char* FLIGHT_TYPE_NAMES[NUM_FLIGHT_TYPES] = { "touch", "action", "roll", "damage", "frame", "match", "watchdog",
+                                                    "draws", "phase_runs" };
 
 /*
-    Function: WaitForTouchRelease
-    Inputs: none
+    Class: FlightEvent
+    Members:
+      - uint32_t timeMs : the last NowMs() reading before the event (wraps after ~49 days)
+      - uint8_t type, phase : FlightEventType and gamePhase
+      - int16_t a, b, c : payload, meaning depends on type:
+          touch (x, y, -), action (side, chosen, hp), roll (0 = accuracy / 1 = damage, roll, accuracy),
+          damage (dmg, target hp, 1 if halved by defend), frame (frame ms, draw calls, -),
+          match (0 = start / 1 = end, p1 hp, p2 hp), watchdog (frame ms, budget ms, draw calls),
+          draws (DrawKind, count, -) and phase_runs (GamePhase, count, -) : what ran in an overrun frame
+*/
+struct FlightEvent {
+    uint32_t timeMs;
+    uint8_t type, phase;
+    int16_t a, b, c;
+};
+FlightEvent flightRing[FLIGHT_EVENTS];
+uint32_t flightCount = 0; // total events recorded; the ring holds the last FLIGHT_EVENTS of them
+
+/*
+    Function: flightRecord
+    Inputs: int type, int a, int b, int c - event type and payload
     Returns: void
-    Purpose: Wait until no touch is present; used to debounce and avoid ghost touches.
-    Author: Pranav Rajesh
+    Purpose: Append one event, overwriting the oldest once the ring is full.
 */
-void WaitForTouchRelease()
+inline void flightRecord(int type, int a = 0, int b = 0, int c = 0)
 {
-    int tx, ty;
-    while (LCD.Touch(&tx, &ty)) {}
-    Sleep(BUTTON_DEBOUNCE_MS);
+    FlightEvent &e = flightRing[flightCount++ & (FLIGHT_EVENTS - 1)];
+    e.timeMs = flightClockMs;
+    e.type = (uint8_t)type; e.phase = (uint8_t)gamePhase;
+    e.a = (int16_t)a; e.b = (int16_t)b; e.c = (int16_t)c;
 }
 
 /*
-    Function: WaitForCleanPress
-    Inputs: int &outX, int &outY (by reference) - returns the touch coordinates
-    Returns: void
-    Purpose: Wait for release, then wait for new press, capture coords, wait for release again.
-    Author: Pranav Rajesh
+    Function: flightDump
+    Inputs: const char* reason - why the dump happened ("request", "watchdog", "fault", ...)
+    Returns: bool (true if the file was written)
+    Purpose: Write the ring, oldest first, to FLIGHT_FILE as one text line per event.
 */
-void WaitForCleanPress(int &outX, int &outY)
+bool flightDump(const char* reason)
 {
-    int x, y;
-    // ensure no current touch
-    while (LCD.Touch(&x, &y)) {}
-    Sleep(BUTTON_DEBOUNCE_MS);
-
-    // wait for touch
-    while (!LCD.Touch(&x, &y)) {}
-    outX = x; outY = y;
-
-    // wait for release
-    while (LCD.Touch(&x, &y)) {}
-    Sleep(BUTTON_DEBOUNCE_MS);
+    FEHFile *f = SD.FOpen(FLIGHT_FILE, "w");
+    if (f == nullptr) return false;
+    uint32_t n = flightCount < (uint32_t)FLIGHT_EVENTS ? flightCount : (uint32_t)FLIGHT_EVENTS;
+    SD.FPrintf(f, "flight log (%s): %u events, last %u kept\n", reason, (unsigned)flightCount, (unsigned)n);
+    for (uint32_t i = flightCount - n; i != flightCount; ++i) {
+        const FlightEvent &e = flightRing[i & (FLIGHT_EVENTS - 1)];
+        SD.FPrintf(f, "%10u %-16s %-10s %6d %6d %6d\n", (unsigned)e.timeMs, PHASE_NAMES[e.phase],
+                   FLIGHT_TYPE_NAMES[e.type], e.a, e.b, e.c);
+    }
+    SD.FClose(f);
+    return true;
 }
 
+#if defined(__unix__) || defined(__APPLE__)
+// Host builds: a crash dumps the ring from the signal handler. stdio, the SD layer and malloc are
+// not async-signal-safe, so the file is opened up front and the handler formats into a stack buffer
+// and uses only ftruncate/write.
+int flightFaultFd = -1;
+
 /*
-    Function: randInt
-    Inputs: int a, int b - inclusive range
-    Returns: random integer in [a,b]
-    Purpose: Convenience random integer generator, making this a function makes the code much more readable. 
-    Author: Aadit Bhatia
+    Function: faultPut / faultPutNum
+    Inputs: char *buf, int &len, const char *s | long long v, int width, bool left (pad on the right)
+    Returns: void
+    Purpose: printf-style "%-*s" and "%*lld" for the fault handler, without touching locale or heap.
 */
-int randInt(int a, int b) 
-{ 
-    return a + (std::rand() % (b - a + 1)); 
+void faultPut(char *buf, int &len, const char *s, int width = 0, bool left = true)
+{
+    int n = 0;
+    while (s[n]) ++n;
+    if (!left) for (int i = n; i < width; ++i) buf[len++] = ' ';
+    for (int i = 0; i < n; ++i) buf[len++] = s[i];
+    if (left) for (int i = n; i < width; ++i) buf[len++] = ' ';
+}
+
+void faultPutNum(char *buf, int &len, long long v, int width)
+{
+    char digits[24];
+    int n = 0;
+    unsigned long long u = v < 0 ? 0ULL - (unsigned long long)v : (unsigned long long)v;
+    do { digits[n++] = (char)('0' + u % 10); u /= 10; } while (u != 0);
+    if (v < 0) digits[n++] = '-';
+    for (int i = n; i < width; ++i) buf[len++] = ' ';
+    while (n > 0) buf[len++] = digits[--n];
 }
 
-// ----------------------------- UI: Menu (comment blocks) -----------------------------
 /*
-    Function: DrawMenuButton
-    Inputs: const char* label, int index (0-based)
-    Returns: void
-    Purpose: Draw a menu rectangle and label at the given index (vertical). This is what is used to create the buttons on the main menu
-    Author: Aadit Bhatia
+    Function: flightOnFault
+    Inputs: int sig - the fatal signal
+    Returns: void (re-raises sig, which now has its default action)
+    Purpose: Write the ring to the pre-opened flight log in flightDump's format, then let the crash proceed.
 */
-void DrawMenuButton(const char* label, int index)
+void flightOnFault(int sig)
 {
-    int y = BTN_START_Y + index * (BTN_H + BTN_GAP);
-    LCD.DrawRectangle(BTN_X, y, BTN_W, BTN_H);
-    LCD.WriteAt(label, BTN_X + 10, y + 12);
+    if (flightFaultFd >= 0 && ftruncate(flightFaultFd, 0) == 0 && lseek(flightFaultFd, 0, SEEK_SET) == 0) {
+        uint32_t count = flightCount;
+        uint32_t n = count < (uint32_t)FLIGHT_EVENTS ? count : (uint32_t)FLIGHT_EVENTS;
+        char line[128];
+        int len = 0;
+        faultPut(line, len, "flight log (fault): ");
+        faultPutNum(line, len, (long long)count, 0);
+        faultPut(line, len, " events, last ");
+        faultPutNum(line, len, (long long)n, 0);
+        faultPut(line, len, " kept\n");
+        ssize_t ok = write(flightFaultFd, line, len);
+        for (uint32_t i = count - n; ok >= 0 && i != count; ++i) {
+            const FlightEvent &e = flightRing[i & (FLIGHT_EVENTS - 1)];
+            len = 0;
+            faultPutNum(line, len, (long long)e.timeMs, 10); line[len++] = ' ';
+            faultPut(line, len, e.phase < NUM_PHASES ? PHASE_NAMES[e.phase] : "?", 16); line[len++] = ' ';
+            faultPut(line, len, e.type < NUM_FLIGHT_TYPES ? FLIGHT_TYPE_NAMES[e.type] : "?", 10); line[len++] = ' ';
+            faultPutNum(line, len, e.a, 6); line[len++] = ' ';
+            faultPutNum(line, len, e.b, 6); line[len++] = ' ';
+            faultPutNum(line, len, e.c, 6); line[len++] = '\n';
+            ok = write(flightFaultFd, line, len);
+        }
+    }
+    raise(sig); // SA_RESETHAND already restored the default action; delivered once we return
 }
 
 /*
-    Function: DrawMainMenu
+    Function: flightInstallFaultHandlers
     Inputs: none
     Returns: void
-    Purpose: Draw the full main menu UI. This function uses DrawMenuButton to create each button on the main menu, plus adding a title and background. 
-    Author: Aadit Bhatia
+    Purpose: Open the flight log for the fault handler (without truncating a previous crash's log)
+             and install the handler for the fatal signals, one-shot.
 */
-void DrawMainMenu()
+void flightInstallFaultHandlers()
 {
-    LCD.Clear(BLACK);
-    LCD.SetFontColor(WHITE);
-    LCD.WriteAt("POKÉMON MINI (SDP)", BTN_X, 10);
+    flightFaultFd = open(FLIGHT_FILE, O_WRONLY | O_CREAT, 0644);
+    struct sigaction sa = {};
+    sa.sa_handler = flightOnFault;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESETHAND;
+    const int fatal[] = { SIGSEGV, SIGABRT, SIGFPE, SIGILL, SIGBUS };
+    for (int sig : fatal) sigaction(sig, &sa, nullptr);
+}
+#endif
 
-    DrawMenuButton("1. Play", 0);
-    DrawMenuButton("2. Instructions", 1);
-    DrawMenuButton("3. Statistics", 2);
-    DrawMenuButton("4. Credits", 3);
+// ----------------------------- FRAME WATCHDOG -----------------------------
+// Every presented frame is checked against a budget. A frame's work time is the interval since the
+// previous frame minus the time spent deliberately idle (SleepMs, waiting for a touch), so pacing
+// delays and a player thinking never count. Consecutive projectile frames are checked on their whole
+// interval instead, because their pacing is the point: a step should take about PROJECTILE_SPEED_MS.
+// The CPU decision has its own think budget. An overrun records what ran in that frame (draw calls by
+// kind, phases entered) in the flight recorder and dumps it, at most once per WATCHDOG_DUMP_GAP_MS.
+const int WATCHDOG_FRAME_BUDGET_MS = 50;
+const int WATCHDOG_PROJECTILE_FACTOR = 3; // projectile step budget = this * PROJECTILE_SPEED_MS
+const int WATCHDOG_CPU_BUDGET_MS = 20;
+const int WATCHDOG_DUMP_GAP_MS = 10000;
 
-    LCD.Update();
-}
+enum DrawKind { DRAW_CLEAR, DRAW_FILL, DRAW_RECT, DRAW_TEXT, NUM_DRAW_KINDS };
 
 /*
-    Function: HighlightMenuButton
-    Inputs: int index (0-based)
+    Class: FrameWatchdog
+    Members:
+      - long overruns : frames or decisions over budget so far
+      - long long worstMs : worst overrun, int worstPhase : phase it happened in
+      - long long idleMs : idle time since the last frame
+      - int idleDepth : > 0 inside a touch wait, so SleepMs calls inside it are not counted twice
+      - long long idleStartMs : when the open touch wait started, or was last credited
+      - int lastFramePhase : phase of the previous frame
+      - uint16_t draws[NUM_DRAW_KINDS] : draw calls since the last frame, by kind
+      - long long lastDumpMs : when the flight log was last dumped for an overrun
+*/
+struct FrameWatchdog {
+    long overruns;
+    long long worstMs;
+    int worstPhase;
+    long long idleMs;
+    int idleDepth;
+    long long idleStartMs;
+    int lastFramePhase;
+    uint16_t draws[NUM_DRAW_KINDS];
+    long long lastDumpMs;
+};
+FrameWatchdog watchdog = {0, 0, PHASE_MENU, 0, 0, 0, PHASE_MENU, {0}, -WATCHDOG_DUMP_GAP_MS};
+
+/*
+    Function: watchdogOverrun
+    Inputs: long long ms - how long it took, int budget - the budget in ms
     Returns: void
-    Purpose: Visually highlight a menu button briefly for feedback. This makes the game more accessible for those with visual impairments.
-    Author: Aadit Bhatia
+    Purpose: Log an overrun with what ran since the last frame, then dump the flight log (rate limited).
 */
-void HighlightMenuButton(int index)
+void watchdogOverrun(long long ms, int budget)
 {
-    if (index < 0 || index >= NUM_MENU_BUTTONS) return;
-    int y = BTN_START_Y + index * (BTN_H + BTN_GAP);
-    LCD.SetFontColor(BLACK);
-    LCD.FillRectangle(BTN_X, y, BTN_W, BTN_H);
-    LCD.SetFontColor(WHITE);
-    //breaks needed so each case doesn't play in order
-    switch(index) {
-        case 0: LCD.WriteAt("1. Play", BTN_X + 10, y + 12); break;
-        case 1: LCD.WriteAt("2. Instructions", BTN_X + 10, y + 12); break;
-        case 2: LCD.WriteAt("3. Statistics", BTN_X + 10, y + 12); break;
-        case 3: LCD.WriteAt("4. Credits", BTN_X + 10, y + 12); break;
+    watchdog.overruns++;
+    if (ms > watchdog.worstMs) { watchdog.worstMs = ms; watchdog.worstPhase = gamePhase; }
+    int draws = 0;
+    for (int k = 0; k < NUM_DRAW_KINDS; ++k) draws += watchdog.draws[k];
+    flightRecord(FR_WATCHDOG, (int)min(ms, 32767LL), budget, draws);
+    for (int k = 0; k < NUM_DRAW_KINDS; ++k) if (watchdog.draws[k]) flightRecord(FR_DRAWS, k, watchdog.draws[k]);
+    for (int p = 0; p < NUM_PHASES; ++p) if (framePhaseRuns[p]) flightRecord(FR_PHASE_RUNS, p, framePhaseRuns[p]);
+    long long now = NowMs();
+    if (now - watchdog.lastDumpMs >= WATCHDOG_DUMP_GAP_MS) {
+        watchdog.lastDumpMs = now;
+        flightDump("watchdog");
     }
-    LCD.Update();
-    SleepMs(160);
 }
 
 /*
-    Function: GetMenuButtonPressed
-    Inputs: none
-    Returns: int (1..NUM_MENU_BUTTONS) or 0 if invalid
-    Purpose: Read a touch and map it robustly to the menu buttons. Recieves whatever button the user pressed based on x,y coords, and maps it to a predetermined
-    menu button. 
-    Author: Aadit Bhatia
+    Function: watchdogOnFrame
+    Inputs: long long intervalMs - time since the previous frame
+    Returns: void
+    Purpose: Check one presented frame against its budget and start counting the next one.
 */
-int GetMenuButtonPressed()
+void watchdogOnFrame(long long intervalMs)
 {
-    int x,y;
-    // wait for touch
-    while (!LCD.Touch(&x,&y)) {}
-    int touchX = x, touchY = y;
-    WaitForTouchRelease();
+    bool projectileStep = gamePhase == PHASE_PROJECTILE && watchdog.lastFramePhase == PHASE_PROJECTILE;
+    long long ms = projectileStep ? intervalMs : intervalMs - watchdog.idleMs;
+    int budget = projectileStep ? WATCHDOG_PROJECTILE_FACTOR * PROJECTILE_SPEED_MS : WATCHDOG_FRAME_BUDGET_MS;
+    if (ms > budget) watchdogOverrun(ms, budget);
+    watchdog.idleMs = 0;
+    watchdog.lastFramePhase = gamePhase;
+    for (int k = 0; k < NUM_DRAW_KINDS; ++k) watchdog.draws[k] = 0;
+    for (int p = 0; p < NUM_PHASES; ++p) framePhaseRuns[p] = 0;
+}
 
-    // filter horizontally
-    if (touchX < BTN_X || touchX > (BTN_X + BTN_W)) return 0;
+/*
+    Class: WaitIdle
+    Members: none (the start of the outermost wait is kept in watchdog.idleStartMs)
+    Purpose: Count a touch wait as idle time for the watchdog for the lifetime of a block.
+*/
+struct WaitIdle {
+    WaitIdle() { if (watchdog.idleDepth++ == 0) watchdog.idleStartMs = NowMs(); }
+    ~WaitIdle() { if (--watchdog.idleDepth == 0) watchdog.idleMs += NowMs() - watchdog.idleStartMs; }
+};
 
-    int rel = touchY - BTN_START_Y;
-    if (rel < 0) return 0;
-    int rowH = BTN_H + BTN_GAP;
-    int index = rel / rowH;
-    if (index >= 0 && index < NUM_MENU_BUTTONS) {
-        int top = BTN_START_Y + index * rowH;
-        int bottom = top + BTN_H;
-        if (touchY >= top && touchY <= bottom) return index + 1;
-    }
-    return 0;
+/*
+    Function: watchdogCreditIdle
+    Inputs: none
+    Returns: void
+    Purpose: Credit the open touch wait as idle up to now, for frames presented while still waiting
+             (the attract screen), so a frame is not charged for the wait before it.
+*/
+void watchdogCreditIdle()
+{
+    if (watchdog.idleDepth == 0) return;
+    long long now = NowMs();
+    watchdog.idleMs += now - watchdog.idleStartMs;
+    watchdog.idleStartMs = now;
 }
 
-// ----------------------------- OOP CLASSES (with comment blocks) -----------------------------
+// ----------------------------- STARTUP TIMELINE -----------------------------
+// main only does what the first menu frame needs; the Pokémon bank and the session snapshot
+// (checkpoint: stats + RNG stream) load in Game::finishStartup right after the menu is on screen,
+// before the first touch is read, so they are always ready by the time Play can be tapped.
+// startupMark records when each step finished; boot-to-menu over STARTUP_MENU_BUDGET_MS is a
+// watchdog overrun.
+const int STARTUP_MAX_MARKS = 8;
+const int STARTUP_MENU_BUDGET_MS = 250;
+
 /*
-    Class: Move
+    Class: StartupMark
     Members:
-      - string name: human-readable move name
-      - int power: a base power used in damage calculation
-      - int accuracy: percentage 0..100
-      - int pp: number of times move can be used
-    Author: Aadit Bhatia
+      - const char* name : step that just finished
+      - long long ms : NowMs() at that point
 */
-struct Move {
-    string name;
-    int power;
-    int accuracy;
-    int pp;
+struct StartupMark {
+    const char* name;
+    long long ms;
 };
+StartupMark startupMarks[STARTUP_MAX_MARKS];
+int startupMarkCount = 0;
+long long bootToMenuMs = -1; // set once the first menu frame is presented
 
 /*
-    Class: Pokemon
-    Members:
-      - string name
-      - int maxHP, hp
-      - int attack, defense
-      - vector<Move> moves
-      - int x,y,w,h : drawn bounding box (used for simple sprite and collisions)
-      - bool defending : whether defend is active
-    Methods:
-      - reset() : restores hp and clears defend
-    Author: Aadit Bhatia
+    Function: startupMark
+    Inputs: const char* name - step that just finished ("main" must come first)
+    Returns: void
 */
-struct Pokemon {
-    string name;
-    int maxHP;
-    int hp;
-    int attack;
-    int defense;
-    vector<Move> moves;
-    int x, y, w, h; // for drawing / collision
-    bool defending;
-    void reset() { hp = maxHP; defending = false; for(auto &m : moves) if (m.pp < 0) m.pp = 0; }
-    bool fainted() const { return hp <= 0; }
-};
+void startupMark(const char* name)
+{
+    if (startupMarkCount < STARTUP_MAX_MARKS) startupMarks[startupMarkCount++] = {name, NowMs()};
+}
 
 /*
-    Class: Player
-    Members:
-      - string label ("Player 1"/"Player 2")
-      - bool isHuman
-      - Pokemon pkmn
-      - int wins (session stat)
-    Author: Pranav Rajesh
+    Function: startupMenuShown
+    Inputs: none
+    Returns: void
+    Purpose: Mark the first presented menu frame and check boot-to-menu against its budget.
 */
-struct Player {
-    string label;
-    bool isHuman;
-    Pokemon pkmn;
-    int wins;
-    Player(): wins(0) {}
-};
+void startupMenuShown()
+{
+    startupMark("menu");
+    bootToMenuMs = startupMarks[startupMarkCount - 1].ms - startupMarks[0].ms;
+    if (bootToMenuMs > STARTUP_MENU_BUDGET_MS) watchdogOverrun(bootToMenuMs, STARTUP_MENU_BUDGET_MS);
+}
 
 /*
-    Class: Game
+    Function: startupTimeline
+    Inputs: none
+    Returns: string - e.g. "menu 4 ms, bank 5 ms, snapshot 9 ms" (times since "main")
+*/
+string startupTimeline()
+{
+    string out;
+    for (int i = 1; i < startupMarkCount; ++i) {
+        if (!out.empty()) out += ", ";
+        out += string(startupMarks[i].name) + " " + to_string(startupMarks[i].ms - startupMarks[0].ms) + " ms";
+    }
+    return out.empty() ? "not recorded" : out;
+}
+
+#if defined(MINIMON_BROADCAST) || defined(MINIMON_VIEWER)
+// ----------------------------- SPECTATOR BROADCAST -----------------------------
+// The host (-DMINIMON_BROADCAST) listens on a UNIX socket. Each viewer picks a stream when it connects:
+//   'F' frames : every draw call of a frame, encoded once into a reference-counted buffer at Update()
+//                and queued to all frame viewers (no per-viewer encoding or copying). A viewer that joins
+//                mid-frame first gets every op since the last Clear, which rebuilds the whole screen.
+//   'A' actions: match start (species, HP, PP, RNG state) and each action; the viewer re-simulates the
+//                match with the same rules and checks every outcome.
+// Sockets are non-blocking. A viewer that falls BROADCAST_MAX_QUEUED messages behind is dropped, so a slow
+// display can never stall the game, and at exit all viewers together get BROADCAST_FLUSH_MS to drain.
+// MINIMON_SPECTATORS=N in the environment makes the host wait for N viewers before it starts.
+const char* BROADCAST_SOCKET = "minimon.sock";
+const int BROADCAST_MAX_VIEWERS = 32;
+const size_t BROADCAST_MAX_QUEUED = 256;
+const size_t BROADCAST_KEYFRAME_MAX = 256 * 1024; // ops kept since the last Clear for joining viewers
+const int BROADCAST_HEADER_BYTES = 5;             // uint32 payload length + uint8 message kind
+const size_t BROADCAST_MAX_MESSAGE = 4 * BROADCAST_KEYFRAME_MAX; // viewers reject longer payloads
+const int BROADCAST_ACTION_BYTES = 6;             // side, chosen, byCpu, outcome, uint16 damage
+const int BROADCAST_FLUSH_MS = 1000;              // shutdown: total time allowed to drain the viewers
+
+enum BroadcastMsg { MSG_FRAME = 1, MSG_MATCH_START, MSG_ACTION };
+enum BroadcastOp { OP_CLEAR = 1, OP_COLOR, OP_FILL, OP_RECT, OP_TEXT_AT, OP_LINE };
+typedef std::shared_ptr<const vector<uint8_t>> SharedMsg;
+
+void putU16(vector<uint8_t> &b, int v) { b.push_back((uint8_t)(v & 0xFF)); b.push_back((uint8_t)((v >> 8) & 0xFF)); }
+void putU32(vector<uint8_t> &b, uint32_t v) { for (int i = 0; i < 4; ++i) b.push_back((uint8_t)(v >> (8 * i))); }
+int getU16(const uint8_t *p) { return (int16_t)(p[0] | (p[1] << 8)); }
+uint32_t getU32(const uint8_t *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+#endif
+
+#ifdef MINIMON_BROADCAST
+/*
+    Class: Broadcaster
     Members:
-      - vector<Pokemon> bank : available Pokémon
-      - Player p1, p2
-      - int gamesPlayed, humanWins, cpuWins
-      - int difficulty (0=Easy,1=Hard)
+      - long frames, messages : frames sealed and messages fanned out
+      - long long bytesEncoded : payload bytes encoded (each once, however many viewers)
     Methods:
-      - loadBank() : populates bank with Pokemon to be randomly chosen
-      - setupMatch(difficulty) : assigns players/mon
-      - runMatch() : runs a single match loop and returns whether to replay
-    Author: Aadit Bhatia and Pranav Rajesh
-    Outside Sources: Learned C++ Lambda Functions from W3Schools + my dad uses them for AWS work so he explained the logic to me
-    Also learned vectors(dynamic arrays) from W3Schools.
+      - start() : open the socket (and wait for MINIMON_SPECTATORS viewers)
+      - clear/color/fill/rect/textAt/line : append one draw op to the current frame (called by ScreenProxy)
+      - endFrame() : seal the frame, fan it out, accept new viewers (called by ScreenProxy::Update)
+      - matchStart/action : action stream for re-simulating viewers
+      - shutdown() : flush the queues at exit, for at most BROADCAST_FLUSH_MS
 */
-class Game {
+class Broadcaster {
 public:
-    vector<Pokemon> bank;
-    Player p1, p2;
-    int gamesPlayed;
-    int humanWins;
-    int cpuWins;
-    int difficulty; // 0 easy, 1 hard
+    long frames, messages;
+    long long bytesEncoded;
 
-    Game(): gamesPlayed(0), humanWins(0), cpuWins(0), difficulty(0) { loadBank(); }
+    Broadcaster(): frames(0), messages(0), bytesEncoded(0), listenFd(-1), sinceClearValid(true) {}
 
-    // loadBank: fill bank with sample Pokémon (stats simplified)
-    //Author: Aadit Bhatia
-    void loadBank()
+    void start()
     {
-        bank.clear();
-        // create helper lambda for moves
-        //used a lambda function to reduce code duplication and make it easier to read
-        auto mk = [](const string &n, int hp, int atk, int def,
-                     const Move &m1, const Move &m2, const Move &m3) -> Pokemon {
-            Pokemon p; p.name = n; p.maxHP = hp; p.hp = hp; p.attack = atk; p.defense = def;
-            p.moves = { m1, m2, m3 };
-            p.w = 48; p.h = 48; p.x = 0; p.y = 0; p.defending = false;
-            return p;
-        };
-        bank.push_back(mk("Pikachu", 40, 11, 6, Move{"Thunder",40,95,15}, Move{"Quick",40,100,20}, Move{"Growl",0,100,25}));
-        bank.push_back(mk("Charmander",45,10,7, Move{"Ember",40,95,15}, Move{"Scratch",35,100,25}, Move{"Tail",0,100,25}));
-        bank.push_back(mk("Squirtle",50,9,9, Move{"Water",40,95,15}, Move{"Tackle",40,100,25}, Move{"Withdraw",0,100,25}));
-        bank.push_back(mk("Bulbasaur",48,9,8, Move{"Vine",45,100,15}, Move{"Tackle",40,100,25}, Move{"Seed",0,90,20}));
-        bank.push_back(mk("Gengar",55,12,6, Move{"Shadow",50,90,12}, Move{"Lick",30,95,20}, Move{"Hypno",0,70,8}));
-        bank.push_back(mk("Onix",60,11,12, Move{"RockT",50,90,15}, Move{"Tackle",40,100,25}, Move{"Harden",0,100,20}));
+        signal(SIGPIPE, SIG_IGN); // a viewer going away must not kill the game
+        listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, BROADCAST_SOCKET, sizeof(addr.sun_path) - 1);
+        unlink(BROADCAST_SOCKET);
+        if (listenFd < 0 || bind(listenFd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listenFd, BROADCAST_MAX_VIEWERS) != 0) {
+            perror("broadcast socket");
+            if (listenFd >= 0) ::close(listenFd);
+            listenFd = -1;
+            return;
+        }
+        const char *wait = getenv("MINIMON_SPECTATORS");
+        int want = wait ? atoi(wait) : 0;
+        if (want > 0) printf("waiting for %d spectator(s) on %s\n", want, BROADCAST_SOCKET);
+        while ((int)viewers.size() < want || anyPending()) {
+            if ((int)viewers.size() < want) acceptViewers(true);
+            else usleep(1000); // connected; waiting for the mode byte
+            readModes();
+        }
+        fcntl(listenFd, F_SETFL, O_NONBLOCK);
     }
 
-    /*
-        Function: assignPlayers
-        Inputs: none
-        Returns: void
-        Purpose: Randomly decides who is human vs CPU, picks two distinct Pokémon from bank,
-                 positions them for drawing on the screen, sets difficulty-dependent seed if needed.
-        Author: Pranav Rajesh
-    */
-    void assignPlayers()
+    void clear(unsigned int color)
     {
-        // randomize who is human: for this project we assign Player1 as human always for clarity,
-        // or flip randomly — we'll flip randomly to satisfy random generation requirement
-        int assignment = randInt(0,1);
-        if (assignment == 0) { p1.isHuman = true; p2.isHuman = false; }
-        else                 { p1.isHuman = false; p2.isHuman = true; }
+        frame.push_back(OP_CLEAR); putU32(frame, color);
+        sinceClear.clear(); sinceClearValid = true; // everything before a clear is invisible now
+        sinceClear.push_back(OP_CLEAR); putU32(sinceClear, color);
+    }
+    void color(unsigned int color) { op(OP_COLOR); putU32(frame, color); keep(frame.end() - 4); }
+    void fill(int x, int y, int w, int h) { op(OP_FILL); box(x, y, w, h); }
+    void rect(int x, int y, int w, int h) { op(OP_RECT); box(x, y, w, h); }
+    void textAt(const char* str, int x, int y)
+    {
+        op(OP_TEXT_AT);
+        size_t start = frame.size();
+        putU16(frame, x); putU16(frame, y);
+        text(str, start);
+    }
+    void line(const char* str) { op(OP_LINE); text(str, frame.size()); }
 
-        p1.label = "Player 1";
-        p2.label = "Player 2";
+    void endFrame()
+    {
+        if (listenFd < 0) return;
+        acceptViewers(false);
+        readModes();
+        frames++;
+        SharedMsg msg = makeMsg(MSG_FRAME, frame);
+        frame.clear();
+        if (sinceClear.size() > BROADCAST_KEYFRAME_MAX) { sinceClear.clear(); sinceClearValid = false; }
 
-        // pick two distinct indices
-        // used randInt function to improve readability
-        // ensure different Pokémon, should be virtually random.
-        int i1 = randInt(0, (int)bank.size()-1);
-        int i2 = randInt(0, (int)bank.size()-1);
-        while (i2 == i1) i2 = randInt(0, (int)bank.size()-1);
+        SharedMsg keyframe; // built at most once per frame, only if someone is waiting to join
+        for (auto &v : viewers) {
+            if (v.mode != 'F') continue;
+            if (v.synced) { enqueue(v, msg); continue; }
+            if (!sinceClearValid) continue; // too much since the last clear: wait for the next one
+            if (!keyframe) keyframe = makeMsg(MSG_FRAME, sinceClear);
+            enqueue(v, keyframe);
+            v.synced = true;
+        }
+        flushAll();
+    }
 
-        p1.pkmn = bank[i1];
-        p2.pkmn = bank[i2];
-        p1.pkmn.reset(); p2.pkmn.reset();
+    void matchStart(const string names[2], const int hp[2], const vector<int> pp[2], bool p1Human, int difficulty,
+                    const uint32_t rng[4])
+    {
+        if (listenFd < 0) return;
+        vector<uint8_t> b;
+        for (int s = 0; s < 2; ++s) {
+            b.push_back((uint8_t)min(names[s].size(), (size_t)255));
+            b.insert(b.end(), names[s].begin(), names[s].begin() + b.back());
+            putU16(b, hp[s]);
+            b.push_back((uint8_t)pp[s].size());
+            for (int v : pp[s]) putU16(b, v);
+        }
+        b.push_back(p1Human ? 1 : 0);
+        b.push_back((uint8_t)difficulty);
+        for (int i = 0; i < 4; ++i) putU32(b, rng[i]);
+        matchLog.clear();
+        sendActions(makeMsg(MSG_MATCH_START, b));
+    }
 
-        // set drawing positions (left/right)
-        p1.pkmn.x = 40; p1.pkmn.y = 60; // left
-        p2.pkmn.x = 220; p2.pkmn.y = 60; // right
+    void action(int side, int chosen, bool byCpu, int outcome, int damage)
+    {
+        if (listenFd < 0) return;
+        vector<uint8_t> b = { (uint8_t)side, (uint8_t)(int8_t)chosen, (uint8_t)byCpu, (uint8_t)outcome };
+        putU16(b, damage);
+        sendActions(makeMsg(MSG_ACTION, b));
     }
 
-    /*
-        Function: computeDamage
-        Inputs: const Pokemon &att, const Pokemon &def, const Move &m
-        Returns: int damage value
-        Purpose: Compute damage value based on simple formula and difficulty modifier
-        Author: Pranav Rajesh
+    void shutdown()
+    {
+        // stay non-blocking: poll for writability against one deadline, so a stalled viewer delays
+        // exit by BROADCAST_FLUSH_MS at most and is then dropped with the rest of its queue
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        long long deadline = (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000 + BROADCAST_FLUSH_MS;
+        flushAll();
+        while (true) {
+            vector<pollfd> waiting;
+            for (auto &v : viewers) if (!v.queue.empty()) waiting.push_back(pollfd{v.fd, POLLOUT, 0});
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            long long left = deadline - ((long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+            if (waiting.empty() || left <= 0) break;
+            if (poll(waiting.data(), waiting.size(), (int)left) < 0 && errno != EINTR) break;
+            flushAll();
+        }
+        for (auto &v : viewers) {
+            if (!v.queue.empty()) printf("broadcast: viewer did not drain in %d ms, dropped\n", BROADCAST_FLUSH_MS);
+            ::close(v.fd);
+        }
+        viewers.clear();
+        if (listenFd >= 0) { ::close(listenFd); unlink(BROADCAST_SOCKET); listenFd = -1; }
+    }
 
-    */
-    int computeDamage(const Pokemon &att, const Pokemon &def, const Move &m)
+    int viewerCount() const { return (int)viewers.size(); }
+
+private:
+    struct Viewer {
+        int fd;
+        char mode;          // 0 until the viewer says 'F' or 'A'
+        bool synced;        // frame viewers: has the keyframe
+        deque<SharedMsg> queue;
+        size_t offset;      // bytes of queue.front() already sent
+        bool dead;
+    };
+
+    int listenFd;
+    vector<Viewer> viewers;
+    vector<uint8_t> frame;      // ops of the frame being drawn
+    vector<uint8_t> sinceClear; // ops since the last clear, for viewers that join later
+    bool sinceClearValid;
+    vector<SharedMsg> matchLog; // action stream of the current match, for action viewers that join later
+
+    void op(int code) { frame.push_back((uint8_t)code); sinceClear.push_back((uint8_t)code); }
+    void keep(vector<uint8_t>::iterator from) { sinceClear.insert(sinceClear.end(), from, frame.end()); }
+    void box(int x, int y, int w, int h)
     {
-        double base = (double)att.attack - ((double)def.defense * 0.45);
-        if (base < 1.0) base = 1.0;
-        double raw = base * (m.power / 20.0);
-        double mult = (randInt(85,100) / 100.0);
-        // difficulty modifies multiplier: Hard increases CPU damage a bit (we do symmetric effect)
-        if (difficulty == 1) raw *= 1.08;
-        raw *= mult;
-        int dmg = (int)(raw + 0.5);
-        if (dmg < MIN_DAMAGE) dmg = MIN_DAMAGE;
-        return dmg;
+        size_t start = frame.size();
+        putU16(frame, x); putU16(frame, y); putU16(frame, w); putU16(frame, h);
+        keep(frame.begin() + start);
+    }
+    void text(const char* str, size_t start)
+    {
+        size_t len = min(strlen(str), (size_t)0x7FFF);
+        putU16(frame, (int)len);
+        frame.insert(frame.end(), str, str + len);
+        keep(frame.begin() + start);
+    }
+
+    SharedMsg makeMsg(int kind, const vector<uint8_t> &payload)
+    {
+        auto m = std::make_shared<vector<uint8_t>>();
+        m->reserve(BROADCAST_HEADER_BYTES + payload.size());
+        putU32(*m, (uint32_t)payload.size());
+        m->push_back((uint8_t)kind);
+        m->insert(m->end(), payload.begin(), payload.end());
+        bytesEncoded += (long long)payload.size();
+        messages++;
+        return m;
+    }
+
+    void sendActions(const SharedMsg &msg)
+    {
+        matchLog.push_back(msg);
+        acceptViewers(false);
+        readModes();
+        for (auto &v : viewers) if (v.mode == 'A') enqueue(v, msg);
+        flushAll();
+    }
+
+    bool anyPending() const
+    {
+        for (auto &v : viewers) if (v.mode == 0) return true;
+        return false;
+    }
+
+    void acceptViewers(bool block)
+    {
+        if (listenFd < 0) return;
+        do {
+            int fd = accept(listenFd, nullptr, nullptr);
+            if (fd < 0) return;
+            fcntl(fd, F_SETFL, O_NONBLOCK);
+            if ((int)viewers.size() >= BROADCAST_MAX_VIEWERS) { ::close(fd); continue; }
+            viewers.push_back(Viewer{fd, 0, false, deque<SharedMsg>(), 0, false});
+        } while (!block);
+    }
+
+    void readModes()
+    {
+        for (auto &v : viewers) {
+            if (v.mode != 0) continue;
+            char m;
+            ssize_t n = recv(v.fd, &m, 1, MSG_DONTWAIT);
+            if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) { v.dead = true; continue; }
+            if (n < 0) continue;
+            v.mode = m == 'A' ? 'A' : 'F';
+            if (v.mode == 'A') for (auto &msg : matchLog) v.queue.push_back(msg); // catch up on this match
+        }
+        prune();
+    }
+
+    void enqueue(Viewer &v, const SharedMsg &msg)
+    {
+        if (v.queue.size() >= BROADCAST_MAX_QUEUED) { v.dead = true; return; } // too slow: drop it
+        v.queue.push_back(msg);
+    }
+
+    void flush(Viewer &v)
+    {
+        while (!v.dead && !v.queue.empty()) {
+            const vector<uint8_t> &m = *v.queue.front();
+            ssize_t n = send(v.fd, m.data() + v.offset, m.size() - v.offset, MSG_DONTWAIT);
+            if (n < 0) { if (errno != EAGAIN && errno != EWOULDBLOCK) v.dead = true; return; }
+            v.offset += (size_t)n;
+            if (v.offset == m.size()) { v.queue.pop_front(); v.offset = 0; }
+        }
+    }
+
+    void flushAll()
+    {
+        for (auto &v : viewers) flush(v);
+        prune();
+    }
+
+    void prune()
+    {
+        for (size_t i = 0; i < viewers.size(); ) {
+            if (viewers[i].dead) { ::close(viewers[i].fd); viewers.erase(viewers.begin() + i); }
+            else ++i;
+        }
+    }
+};
+Broadcaster broadcast;
+
+/*
+    Function: broadcastShutdown
+    Inputs: none
+    Returns: void
+    Purpose: atexit hook: deliver what is still queued so viewers see the end of the session.
+*/
+void broadcastShutdown() { broadcast.shutdown(); }
+#endif
+
+// ----------------------------- SCREEN ACCESS -----------------------------
+/*
+    Class: Rect
+    Members:
+      - int x, y, w, h : screen rectangle (w, h in pixels)
+    Methods:
+      - intersects(o) : true if the two rectangles share any pixel
+      - contains(o) : true if o lies completely inside this rectangle
+      - unite(o) : grow to the bounding box of both rectangles
+*/
+struct Rect {
+    int x, y, w, h;
+    bool intersects(const Rect &o) const { return x < o.x + o.w && o.x < x + w && y < o.y + o.h && o.y < y + h; }
+    bool contains(const Rect &o) const { return o.x >= x && o.y >= y && o.x + o.w <= x + w && o.y + o.h <= y + h; }
+    void unite(const Rect &o)
+    {
+        int x1 = max(x + w, o.x + o.w), y1 = max(y + h, o.y + o.h);
+        x = min(x, o.x); y = min(y, o.y);
+        w = x1 - x; h = y1 - y;
+    }
+};
+
+// touch-to-photon latency histogram: LATENCY_BUCKETS buckets of LATENCY_BUCKET_MS each, the last one open-ended
+const int LATENCY_BUCKETS = 16;
+const int LATENCY_BUCKET_MS = 50;
+
+/*
+    Class: TouchLatency
+    Members:
+      - long count : touches that produced visible feedback
+      - long long totalMs, minMs, maxMs
+      - long buckets[LATENCY_BUCKETS] : latency histogram
+*/
+struct TouchLatency {
+    long count;
+    long long totalMs, minMs, maxMs;
+    long buckets[LATENCY_BUCKETS];
+};
+
+/*
+    Class: ScreenProxy
+    Members:
+      - long frames : number of LCD.Update() calls (frames presented)
+      - long drawCalls : number of clear/rectangle/text calls
+      - TouchLatency latency : time from a touch going down to the first presented frame that drew at the touch point
+      - vector<string> text : (automation builds) text written since the last clear
+      - vector<uint32_t> shadow : (automation builds) software copy of the screen, SCREEN_W x SCREEN_H, 0xRRGGBB.
+                                  Text is drawn as one solid 12x17 cell per character, tinted by the character code,
+                                  so any change in text still changes pixels.
+    Purpose: Thin pass-through to LCD used for all drawing, so every flow can be measured
+             in frames and draw calls. Counting costs one increment per call.
+*/
+class ScreenProxy {
+public:
+    long frames;
+    long drawCalls;
+    TouchLatency latency;
+#ifdef MINIMON_AUTOMATION
+    vector<string> text;
+    vector<uint32_t> shadow;
+#endif
+
+    ScreenProxy(): frames(0), drawCalls(0), touchPending(false), touchDrawn(false), touchX(0), touchY(0), touchDownMs(0),
+                   lastFrameMs(0), frameDrawStart(0)
+    {
+        latency = TouchLatency{0, 0, 0, 0, {0}};
+#ifdef MINIMON_AUTOMATION
+        shadow.assign(SCREEN_W * SCREEN_H, 0);
+        fontColor = 0xFFFFFF;
+        textRow = 0;
+#endif
+    }
+
+    void Clear(unsigned int color)
+    {
+        drawCalls++;
+        watchdog.draws[DRAW_CLEAR]++;
+        touchDrawn = touchDrawn || touchPending;
+#ifdef MINIMON_AUTOMATION
+        text.clear();
+        std::fill(shadow.begin(), shadow.end(), (uint32_t)color);
+        textRow = 0;
+#endif
+#ifdef MINIMON_BROADCAST
+        broadcast.clear(color);
+#endif
+        LCD.Clear(color);
+    }
+    void SetFontColor(unsigned int color)
+    {
+#ifdef MINIMON_AUTOMATION
+        fontColor = color;
+#endif
+#ifdef MINIMON_BROADCAST
+        broadcast.color(color);
+#endif
+        LCD.SetFontColor(color);
+    }
+    void FillRectangle(int x, int y, int w, int h)
+    {
+        drawCalls++;
+        watchdog.draws[DRAW_FILL]++;
+        noteDraw(x, y, w, h);
+#ifdef MINIMON_AUTOMATION
+        shadowFill(x, y, w, h, fontColor);
+#endif
+#ifdef MINIMON_BROADCAST
+        broadcast.fill(x, y, w, h);
+#endif
+        LCD.FillRectangle(x, y, w, h);
+    }
+    void DrawRectangle(int x, int y, int w, int h)
+    {
+        drawCalls++;
+        watchdog.draws[DRAW_RECT]++;
+        noteDraw(x, y, w + 1, h + 1);
+#ifdef MINIMON_AUTOMATION
+        shadowFill(x, y, w + 1, 1, fontColor); shadowFill(x, y + h, w + 1, 1, fontColor);
+        shadowFill(x, y, 1, h + 1, fontColor); shadowFill(x + w, y, 1, h + 1, fontColor);
+#endif
+#ifdef MINIMON_BROADCAST
+        broadcast.rect(x, y, w, h);
+#endif
+        LCD.DrawRectangle(x, y, w, h);
+    }
+    void WriteAt(const char* str, int x, int y)
+    {
+        drawCalls++;
+        watchdog.draws[DRAW_TEXT]++;
+        noteDraw(x, y, (int)string(str).size() * 12, 17);
+#ifdef MINIMON_AUTOMATION
+        text.push_back(str);
+        shadowText(str, x, y);
+#endif
+#ifdef MINIMON_BROADCAST
+        broadcast.textAt(str, x, y);
+#endif
+        LCD.WriteAt(str, x, y);
+    }
+    void WriteLine(const char* str)
+    {
+        drawCalls++;
+        watchdog.draws[DRAW_TEXT]++;
+#ifdef MINIMON_AUTOMATION
+        text.push_back(str);
+        shadowText(str, 0, textRow * 17);
+        textRow++;
+#endif
+#ifdef MINIMON_BROADCAST
+        broadcast.line(str);
+#endif
+        LCD.WriteLine(str);
+    }
+    void Update()
+    {
+        frames++;
+        LCD.Update();
+        long long now = NowMs();
+        flightRecord(FR_FRAME, (int)min(now - lastFrameMs, 32767LL), (int)min(drawCalls - frameDrawStart, 32767L));
+        watchdogOnFrame(now - lastFrameMs);
+        lastFrameMs = now; frameDrawStart = drawCalls;
+        if (touchPending && touchDrawn) {
+            recordLatency(now - touchDownMs);
+            touchPending = false;
+        }
+#ifdef MINIMON_BROADCAST
+        broadcast.endFrame();
+#endif
+#ifdef MINIMON_AUTOMATION
+        onFrame();
+#endif
     }
 
     /*
-        Function: getPokemonColor
-        Inputs: const string &name
-        Purpose: Simple utility to assign a color based on the Pokémon name for sprite
-        Author: Aadit Bhatia 
+        Function: TouchDown
+        Inputs: int x, int y - where the touch went down, long long ms - when
+        Returns: void
+        Purpose: Start timing a touch; the clock stops at the first frame that draws over the touch point.
     */
-    int getPokemonColor(const string &name) {
-        if (name == "Pikachu") return YELLOW;
-        if (name == "Charmander") return RED;
-        if (name == "Squirtle") return BLUE;
-        if (name == "Bulbasaur") return GREEN;
-        if (name == "Gengar") return MAGENTA;
-        if (name == "Onix") return GRAY;
-        return WHITE;
+    void TouchDown(int x, int y, long long ms)
+    {
+        touchPending = true; touchDrawn = false;
+        touchX = x; touchY = y; touchDownMs = ms;
+    }
+
+private:
+    bool touchPending, touchDrawn;
+    int touchX, touchY;
+    long long touchDownMs;
+    long long lastFrameMs; // when the previous frame was presented
+    long frameDrawStart;   // drawCalls at the previous frame
+#ifdef MINIMON_AUTOMATION
+    unsigned int fontColor;
+    int textRow;
+
+    void onFrame();
+
+    void shadowFill(int x, int y, int w, int h, uint32_t color)
+    {
+        int x0 = max(x, 0), y0 = max(y, 0), x1 = min(x + w, SCREEN_W), y1 = min(y + h, SCREEN_H);
+        for (int r = y0; r < y1; ++r) {
+            for (int c = x0; c < x1; ++c) shadow[r * SCREEN_W + c] = color;
+        }
+    }
+    void shadowText(const char* str, int x, int y)
+    {
+        for (int i = 0; str[i] != '\0'; ++i) {
+            if (str[i] == ' ') continue;
+            shadowFill(x + i * 12, y, 12, 17, (fontColor ^ ((unsigned char)str[i] * 0x010101u)) & 0xFFFFFF);
+        }
+    }
+#endif
+
+    void noteDraw(int x, int y, int w, int h)
+    {
+        if (touchPending && touchX >= x && touchX < x + w && touchY >= y && touchY < y + h) touchDrawn = true;
+    }
+    void recordLatency(long long ms)
+    {
+        latency.count++;
+        latency.totalMs += ms;
+        if (latency.count == 1 || ms < latency.minMs) latency.minMs = ms;
+        if (ms > latency.maxMs) latency.maxMs = ms;
+        int b = (int)(ms / LATENCY_BUCKET_MS);
+        latency.buckets[b < LATENCY_BUCKETS ? b : LATENCY_BUCKETS - 1]++;
+    }
+};
+ScreenProxy Screen;
+
+/*
+    Function: latencySummary
+    Inputs: none
+    Returns: string - "n=.. avg=..ms min=..ms max=..ms", or "no data"
+    Purpose: One-line summary of the touch-to-photon latency measured so far.
+*/
+string latencySummary()
+{
+    const TouchLatency &l = Screen.latency;
+    if (l.count == 0) return "no data";
+    return "n=" + to_string(l.count) + " avg=" + to_string(l.totalMs / l.count) + "ms min=" + to_string(l.minMs) +
+           "ms max=" + to_string(l.maxMs) + "ms";
+}
+
+// ----------------------------- SPRITE ASSETS -----------------------------
+// Sprites are stored run-length encoded: one byte per run, (length << 2) | palette index.
+// Runs never cross a row. Palette index 0 is transparent, 1 is the species body color,
+// 2 is black, 3 is white. Game::drawSprite reads the runs straight from flash and merges identical
+// spans of consecutive rows into one filled rectangle, so no decoded copy of a sprite exists in RAM.
+const int SPRITE_SCALE = 4; // each sprite pixel is drawn as a 4x4 block
+const int SPRITE_MAX_COLS = 32;
+const int SPRITE_MAX_SPANS = SPRITE_MAX_COLS / 2 + 1; // spans in one row are separated by at least one pixel
+
+constexpr uint8_t rleRun(int length, int color) { return (uint8_t)((length << 2) | color); }
+
+/*
+    Class: SpriteAsset
+    Members:
+      - const uint8_t *runs, int numRuns : RLE data
+      - int cols, rows : size in sprite pixels
+*/
+struct SpriteAsset {
+    const uint8_t *runs;
+    int numRuns;
+    int cols, rows;
+};
+
+// 12x12 creature facing right (drawn mirrored for the right-hand Pokémon): 47 bytes instead of 144
+const uint8_t MON_SPRITE_RLE[] = {
+    rleRun(3,0), rleRun(2,1), rleRun(3,0), rleRun(2,1), rleRun(2,0),                // ...BB...BB..
+    rleRun(3,0), rleRun(3,1), rleRun(1,0), rleRun(3,1), rleRun(2,0),                // ...BBB.BBB..
+    rleRun(2,0), rleRun(9,1), rleRun(1,0),                                          // ..BBBBBBBBB.
+    rleRun(2,0), rleRun(5,1), rleRun(1,3), rleRun(1,2), rleRun(2,1), rleRun(1,0),   // ..BBBBBWKBB.
+    rleRun(1,0), rleRun(6,1), rleRun(2,2), rleRun(2,1), rleRun(1,0),                // .BBBBBBKKBB.
+    rleRun(1,0), rleRun(11,1),                                                      // .BBBBBBBBBBB
+    rleRun(1,0), rleRun(8,1), rleRun(2,2), rleRun(1,0),                             // .BBBBBBBBKK.
+    rleRun(10,1), rleRun(2,0),                                                      // BBBBBBBBBB..
+    rleRun(10,1), rleRun(2,0),                                                      // BBBBBBBBBB..
+    rleRun(1,0), rleRun(9,1), rleRun(2,0),                                          // .BBBBBBBBB..
+    rleRun(2,0), rleRun(2,1), rleRun(3,0), rleRun(2,1), rleRun(3,0),                // ..BB...BB...
+    rleRun(1,0), rleRun(3,1), rleRun(2,0), rleRun(3,1), rleRun(3,0),                // .BBB..BBB...
+};
+const SpriteAsset MON_SPRITE = { MON_SPRITE_RLE, (int)sizeof(MON_SPRITE_RLE), 12, 12 };
+
+/*
+    Class: SpriteSpan
+    Members:
+      - uint8_t col, len : columns covered, in sprite pixels
+      - uint8_t row0 : first row of the rectangle this span has grown into
+*/
+struct SpriteSpan {
+    uint8_t col, len, row0;
+};
+
+#ifdef MINIMON_PROFILE
+// ----------------------------- SAMPLING PROFILER -----------------------------
+// A SIGPROF interval timer fires every PROFILE_PERIOD_US of CPU time. The handler captures the
+// call stack, tags it with gamePhase and counts it in a fixed open-addressing table, so memory stays
+// bounded however long the session runs and the handler never allocates. At exit the table is
+// symbolized and written as folded stacks ("phase;outer;...;inner count") for flamegraph.pl.
+const int PROFILE_PERIOD_US = 4000;  // 250 Hz: unwinding costs ~20 us, so this keeps overhead well under 2%
+const int PROFILE_MAX_DEPTH = 32;
+const int PROFILE_TABLE_SIZE = 4096; // distinct (phase, stack) pairs; power of two
+const int PROFILE_SKIP_FRAMES = 2;   // the handler itself and the signal trampoline
+const char* PROFILE_FILE = "profile.folded";
+
+/*
+    Class: ProfileStack
+    Members:
+      - uint64_t hash : 0 = empty slot
+      - int phase, depth
+      - void *pc[PROFILE_MAX_DEPTH] : return addresses, innermost first
+      - uint32_t count : samples that hit this stack
+*/
+struct ProfileStack {
+    uint64_t hash;
+    int phase, depth;
+    void *pc[PROFILE_MAX_DEPTH];
+    uint32_t count;
+};
+ProfileStack profileTable[PROFILE_TABLE_SIZE];
+uint32_t profileSamples = 0, profileDropped = 0;
+long long profileHandlerNs = 0;           // time spent inside the handler, to report overhead
+volatile sig_atomic_t profileStopRequested = 0;
+
+long long profileClockNs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+    Function: profileOnSignal
+    Inputs: int sig (SIGPROF)
+    Returns: void
+    Purpose: Take one sample. Only async-signal-safe work: backtrace into a stack buffer, hash, table insert.
+*/
+void profileOnSignal(int)
+{
+    long long t0 = profileClockNs();
+    void *pc[PROFILE_MAX_DEPTH + PROFILE_SKIP_FRAMES];
+    int n = backtrace(pc, PROFILE_MAX_DEPTH + PROFILE_SKIP_FRAMES) - PROFILE_SKIP_FRAMES;
+    if (n < 0) n = 0;
+    int phase = gamePhase;
+    uint64_t h = 1469598103934665603ULL ^ (uint64_t)phase;
+    for (int i = 0; i < n; ++i) { h ^= (uint64_t)(uintptr_t)pc[i + PROFILE_SKIP_FRAMES]; h *= 1099511628211ULL; }
+    if (h == 0) h = 1;
+    profileSamples++;
+    for (int probe = 0; probe < PROFILE_TABLE_SIZE; ++probe) {
+        ProfileStack &e = profileTable[(h + probe) & (PROFILE_TABLE_SIZE - 1)];
+        if (e.hash == h) { e.count++; break; }
+        if (e.hash == 0) {
+            e.hash = h; e.phase = phase; e.depth = n; e.count = 1;
+            memcpy(e.pc, pc + PROFILE_SKIP_FRAMES, n * sizeof(void*));
+            break;
+        }
+        if (probe == PROFILE_TABLE_SIZE - 1) profileDropped++;
+    }
+    profileHandlerNs += profileClockNs() - t0;
+}
+
+/*
+    Function: profileFrameName
+    Inputs: void *pc
+    Returns: string - demangled function name, or the raw address if it has no symbol
+*/
+string profileFrameName(void *pc)
+{
+    char **sym = backtrace_symbols(&pc, 1);
+    string raw = sym ? sym[0] : "";
+    free(sym);
+    // glibc format: "binary(mangled+0xoff) [0xaddr]"
+    size_t open = raw.find('('), plus = raw.find('+', open);
+    if (open != string::npos && plus != string::npos && plus > open + 1) {
+        string mangled = raw.substr(open + 1, plus - open - 1);
+        int status = 0;
+        char *dem = abi::__cxa_demangle(mangled.c_str(), nullptr, nullptr, &status);
+        string name = (status == 0 && dem) ? dem : mangled;
+        free(dem);
+        return name;
+    }
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%p", pc);
+    return buf;
+}
+
+/*
+    Function: profileDump
+    Inputs: none
+    Returns: void
+    Purpose: atexit hook: stop sampling, write PROFILE_FILE and print per-phase totals and the overhead.
+*/
+void profileDump()
+{
+    itimerval off = {};
+    setitimer(ITIMER_PROF, &off, nullptr);
+    signal(SIGPROF, SIG_IGN);
+
+    map<void*, string> names; // symbolize each address once
+    map<string, uint32_t> folded;
+    uint32_t perPhase[NUM_PHASES] = {0};
+    for (const ProfileStack &e : profileTable) {
+        if (e.hash == 0) continue;
+        string line = PHASE_NAMES[e.phase];
+        for (int i = e.depth - 1; i >= 0; --i) {
+            auto it = names.find(e.pc[i]);
+            if (it == names.end()) it = names.insert(make_pair(e.pc[i], profileFrameName(e.pc[i]))).first;
+            line += ";" + it->second;
+        }
+        folded[line] += e.count;
+        perPhase[e.phase] += e.count;
+    }
+    FILE *f = fopen(PROFILE_FILE, "w");
+    if (f) {
+        for (auto &kv : folded) fprintf(f, "%s %u\n", kv.first.c_str(), kv.second);
+        fclose(f);
     }
+    printf("profile: %u samples (%u dropped) -> %s\n", profileSamples, profileDropped, PROFILE_FILE);
+    for (int p = 0; p < NUM_PHASES; ++p)
+        if (perPhase[p]) printf("  %-17s %6u  %5.1f%%\n", PHASE_NAMES[p], perPhase[p], 100.0 * perPhase[p] / profileSamples);
+    double sampledNs = (double)profileSamples * PROFILE_PERIOD_US * 1000.0;
+    if (profileSamples) printf("  handler overhead: %.2f%% of sampled CPU time\n", 100.0 * profileHandlerNs / sampledNs);
+}
+
+/*
+    Function: profileStart
+    Inputs: none
+    Returns: void
+    Purpose: Install the handlers and start the timer. SIGINT only sets a flag; SleepMs exits on it so the
+             profile is still written when a real-time session is stopped with Ctrl+C.
+*/
+void profileStart()
+{
+    void *warm[1];
+    backtrace(warm, 1); // first call loads the unwinder (allocates), so do it outside the handler
+    struct sigaction sa = {};
+    sa.sa_handler = profileOnSignal;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGPROF, &sa, nullptr);
+    signal(SIGINT, [](int) { profileStopRequested = 1; });
+    atexit(profileDump);
+    itimerval tv;
+    tv.it_interval.tv_sec = 0; tv.it_interval.tv_usec = PROFILE_PERIOD_US;
+    tv.it_value = tv.it_interval;
+    setitimer(ITIMER_PROF, &tv, nullptr);
+}
+#endif
+
+// ----------------------------- CLOCK + TOUCH INPUT -----------------------------
+// All pacing goes through SleepMs/NowMs and all touch input through ReadTouch.
+// Building with -DMINIMON_VIRTUAL_CLOCK (host only) swaps in a virtual clock: sleeps advance
+// simulated time instantly and touches come from a script keyed to virtual timestamps,
+// so a whole session runs in milliseconds while every delay keeps its relative timing.
+#ifdef MINIMON_VIRTUAL_CLOCK
+/*
+    Class: TouchEvent
+    Members:
+      - long long startMs, endMs : virtual time the finger is down for [startMs, endMs)
+      - int x, y : touch position
+*/
+struct TouchEvent {
+    long long startMs, endMs;
+    int x, y;
+};
+long long virtualNowMs = 0;
+vector<TouchEvent> touchScript; // sorted by startMs
+size_t touchScriptPos = 0;      // first event that has not ended yet
+const int VIRTUAL_POLL_MS = 1;  // virtual time one touch poll takes
+const int VIRTUAL_IDLE_LIMIT_MS = 60000; // stop once the script is over and nothing happens for this long
+
+/*
+    Function: loadTouchScript
+    Inputs: const char* path - text file, one event per line: "startMs x y [holdMs]"
+    Returns: bool (true if the file could be read)
+    Purpose: Fill touchScript for a virtual-clock run. holdMs defaults to 50.
+*/
+bool loadTouchScript(const char* path)
+{
+    FILE *f = fopen(path, "r");
+    if (f == nullptr) return false;
+    char line[128];
+    while (fgets(line, sizeof(line), f)) {
+        long long start; int x, y, hold = 50;
+        int n = sscanf(line, "%lld %d %d %d", &start, &x, &y, &hold);
+        if (n >= 3) touchScript.push_back({start, start + hold, x, y});
+    }
+    fclose(f);
+    return true;
+}
+
+/*
+    Function: virtualScriptFinished
+    Inputs: none
+    Returns: void (does not return)
+    Purpose: Called once the touch script is used up and the game is idle waiting for input: report and
+             exit, with status 1 if any frame overran its watchdog budget.
+*/
+void virtualScriptFinished()
+{
+    printf("touch script finished at %lld ms virtual time\n", virtualNowMs);
+    printf("frame watchdog: %ld overruns\n", watchdog.overruns);
+    exit(watchdog.overruns ? 1 : 0);
+}
+#endif
+
+#ifdef MINIMON_AUTOMATION
+// UI automation driver. A script is a list of steps, run against the real menu and battle code:
+//   tap <target> [count] [maxFrames] [maxMs]   - tap a named button (or "x,y"), optionally with a budget per tap
+//   expect <text>                             - the current screen must show this text
+//   snapshot <name> [frame]                   - compare the screen with golden_<name>.ppm, when idle or at the
+//                                               given frame after the previous tap
+// The script and goldens are kept in automation/. A missing golden fails the run; set
+// MINIMON_RECORD_GOLDENS=1 (make record-goldens) to write fresh goldens instead of comparing.
+// A tap is delivered only when the game is waiting for a fresh press, and each tap is measured
+// until the next one is delivered: frames, draw calls and virtual time. The run fails if an
+// expectation is not met or a budget is exceeded, so user journeys double as regression benchmarks.
+
+/*
+    Class: UiStep / UiStepResult
+    Members:
+      - UiStep: bool isTap, string name, int x, y, maxFrames, long long maxMs (-1 = no budget), string text,
+                int atFrame (snapshots: capture this many frames after the previous tap, 0 = when idle)
+      - UiStepResult: string name, long frames, drawCalls, long long ms, bool ok
+*/
+struct UiStep {
+    bool isTap;
+    string name;
+    int x, y;
+    int maxFrames;
+    long long maxMs;
+    string text;
+    int atFrame;
+};
+struct UiStepResult {
+    string name;
+    long frames, drawCalls;
+    long long ms;
+    bool ok;
+};
+vector<UiStep> uiSteps;
+size_t uiStepPos = 0;
+int uiIdlePolls = 0;          // consecutive touch polls with no touch and no sleep in between
+vector<UiStepResult> uiResults;
+bool uiStepOpen = false;
+long uiFrames0 = 0, uiDraws0 = 0;
+long long uiStart0 = 0;
+bool uiFailed = false;
+
+/*
+    Function: uiTarget
+    Inputs: const string &name, int &x, int &y (by reference)
+    Returns: bool (true if the name is a known button or an "x,y" pair)
+    Purpose: Map a script button name to a point inside that button.
+*/
+bool uiTarget(const string &name, int &x, int &y)
+{
+    struct Named { const char* name; int x, y; };
+    const int bx = BTN_X + BTN_W / 2, rowH = BTN_H + BTN_GAP, by = BTN_START_Y + BTN_H / 3;
+    const int lx = BBTN_LEFT_X + BBTN_W / 2, rx = BBTN_RIGHT_X + BBTN_W / 2;
+    const int r0 = BBTN_START_Y + BBTN_H / 2, r1 = r0 + BBTN_H + BBTN_GAP;
+    const Named names[] = {
+        {"Play", bx, by}, {"Instructions", bx, by + rowH}, {"Statistics", bx, by + 2 * rowH}, {"Credits", bx, by + 3 * rowH},
+        {"Easy", 90, 70}, {"Hard", 230, 70}, {"Start", 160, 130},
+        {"Move1", lx, r0}, {"Move2", rx, r0}, {"Move3", lx, r1}, {"Run", rx, r1},
+        {"Yes", SCREEN_W / 2, SCREEN_H / 4}, {"No", SCREEN_W / 2, 3 * SCREEN_H / 4},
+    };
+    for (auto &n : names) if (name == n.name) { x = n.x; y = n.y; return true; }
+    return sscanf(name.c_str(), "%d,%d", &x, &y) == 2;
+}
+
+/*
+    Function: loadUiScript
+    Inputs: const char* path
+    Returns: bool (true if the script was read without errors)
+    Purpose: Parse an automation script into uiSteps ('#' starts a comment line).
+*/
+bool loadUiScript(const char* path)
+{
+    FILE *f = fopen(path, "r");
+    if (f == nullptr) return false;
+    char line[256];
+    bool ok = true;
+    while (fgets(line, sizeof(line), f)) {
+        char cmd[32], arg[128];
+        if (sscanf(line, "%31s", cmd) != 1 || cmd[0] == '#') continue;
+        if (string(cmd) == "tap") {
+            int count = 1, maxFrames = -1;
+            long long maxMs = -1;
+            UiStep st;
+            if (sscanf(line, "%*s %127s %d %d %lld", arg, &count, &maxFrames, &maxMs) < 1 || !uiTarget(arg, st.x, st.y)) {
+                printf("bad step: %s", line); ok = false; continue;
+            }
+            st.isTap = true; st.name = arg; st.maxFrames = maxFrames; st.maxMs = maxMs; st.atFrame = 0;
+            for (int i = 0; i < count; ++i) uiSteps.push_back(st);
+        } else if (string(cmd) == "expect") {
+            string text = line;
+            size_t at = text.find("expect") + 6;
+            text = text.substr(at);
+            text.erase(0, text.find_first_not_of(" \t"));
+            text.erase(text.find_last_not_of(" \t\r\n") + 1);
+            uiSteps.push_back({false, "expect", 0, 0, -1, -1, text, 0});
+        } else if (string(cmd) == "snapshot") {
+            int frame = 0;
+            if (sscanf(line, "%*s %127s %d", arg, &frame) < 1) { printf("bad step: %s", line); ok = false; continue; }
+            uiSteps.push_back({false, "snapshot", 0, 0, -1, -1, arg, frame});
+        } else {
+            printf("unknown command: %s", line); ok = false;
+        }
+    }
+    fclose(f);
+    return ok;
+}
+
+/*
+    Function: diffFrames
+    Inputs: const uint32_t *a, const uint32_t *b - two SCREEN_W x SCREEN_H frames, Rect &box (by reference)
+    Returns: int number of differing rows (0 = identical); box gets the bounding box of all changed pixels
+    Purpose: Fast pixel diff. Equal rows are skipped with memcmp (vectorized by the C library);
+             differing rows are scanned two pixels at a time as 64-bit words.
+*/
+int diffFrames(const uint32_t *a, const uint32_t *b, Rect &box)
+{
+    int rows = 0, x0 = SCREEN_W, x1 = -1, y0 = SCREEN_H, y1 = -1;
+    for (int r = 0; r < SCREEN_H; ++r) {
+        const uint32_t *ra = a + r * SCREEN_W, *rb = b + r * SCREEN_W;
+        if (memcmp(ra, rb, SCREEN_W * sizeof(uint32_t)) == 0) continue;
+        rows++;
+        y0 = min(y0, r); y1 = r;
+        for (int c = 0; c < SCREEN_W; c += 2) {
+            uint64_t wa, wb;
+            memcpy(&wa, ra + c, 8); memcpy(&wb, rb + c, 8);
+            if (wa == wb) continue;
+            int first = (ra[c] != rb[c]) ? c : c + 1;
+            int last = (ra[c + 1] != rb[c + 1]) ? c + 1 : c;
+            x0 = min(x0, first); x1 = max(x1, last);
+        }
+    }
+    box = rows ? Rect{x0, y0, x1 - x0 + 1, y1 - y0 + 1} : Rect{0, 0, 0, 0};
+    return rows;
+}
+
+/*
+    Function: diffThroughput
+    Inputs: const vector<uint32_t> &frame - a full screen to compare against
+    Returns: double full-frame comparisons per second (CPU time)
+    Purpose: Time diffFrames against a copy of the frame with one changed pixel per row group, so both
+             the memcmp skip and the word scan are exercised.
+*/
+double diffThroughput(const vector<uint32_t> &frame)
+{
+    vector<uint32_t> other(frame);
+    for (int r = 0; r < SCREEN_H; r += 16) other[r * SCREEN_W + (r * 7) % SCREEN_W] ^= 0xFFFFFF;
+    Rect box;
+    long rows = 0, n = 0;
+    clock_t start = clock(), elapsed = 0;
+    for (; elapsed < CLOCKS_PER_SEC / 5; elapsed = clock() - start)
+        for (int k = 0; k < 100; ++k, ++n) rows += diffFrames(frame.data(), other.data(), box);
+    return rows > 0 ? n / ((double)elapsed / CLOCKS_PER_SEC) : 0.0;
+}
 
+/*
+    Function: uiSnapshot
+    Inputs: const string &name
+    Returns: void
+    Purpose: Compare the shadow screen with golden_<name>.ppm and report the changed area. A missing
+             golden is a failure unless MINIMON_RECORD_GOLDENS is set, in which case the golden is
+             (re)written instead.
+*/
+void uiSnapshot(const string &name)
+{
+    string path = "golden_" + name + ".ppm";
+    const char *record = getenv("MINIMON_RECORD_GOLDENS");
+    if (record != nullptr && *record != '\0' && *record != '0') {
+        FILE *f = fopen(path.c_str(), "wb");
+        if (f == nullptr) { printf("snapshot %s: cannot write %s\n", name.c_str(), path.c_str()); uiFailed = true; return; }
+        fprintf(f, "P6\n%d %d\n255\n", SCREEN_W, SCREEN_H);
+        for (uint32_t px : Screen.shadow) {
+            unsigned char rgb[3] = { (unsigned char)(px >> 16), (unsigned char)(px >> 8), (unsigned char)px };
+            fwrite(rgb, 1, 3, f);
+        }
+        fclose(f);
+        printf("snapshot %s: recorded\n", name.c_str());
+        return;
+    }
+    FILE *f = fopen(path.c_str(), "rb");
+    if (f == nullptr) {
+        printf("snapshot %s: no %s (set MINIMON_RECORD_GOLDENS=1 to record it)\n", name.c_str(), path.c_str());
+        uiFailed = true;
+        if (!uiResults.empty()) uiResults.back().ok = false;
+        return;
+    }
+    int w = 0, h = 0, maxv = 0;
+    vector<uint32_t> golden(SCREEN_W * SCREEN_H, 0);
+    bool ok = fscanf(f, "P6 %d %d %d", &w, &h, &maxv) == 3 && w == SCREEN_W && h == SCREEN_H && fgetc(f) != EOF;
+    for (size_t i = 0; ok && i < golden.size(); ++i) {
+        unsigned char rgb[3];
+        if (fread(rgb, 1, 3, f) != 3) ok = false;
+        golden[i] = ((uint32_t)rgb[0] << 16) | ((uint32_t)rgb[1] << 8) | rgb[2];
+    }
+    fclose(f);
+    if (!ok) { printf("snapshot %s: unreadable %s\n", name.c_str(), path.c_str()); uiFailed = true; return; }
+
+    Rect box;
+    if (diffFrames(golden.data(), Screen.shadow.data(), box) == 0) return;
+    printf("snapshot %s: differs in x=%d y=%d w=%d h=%d\n", name.c_str(), box.x, box.y, box.w, box.h);
+    uiFailed = true;
+    if (!uiResults.empty()) uiResults.back().ok = false;
+}
+
+// snapshots armed to be taken at a given frame count (see uiOnIdle)
+vector<pair<long, string>> uiFrameSnapshots;
+
+/*
+    Function: ScreenProxy::onFrame
+    Inputs: none
+    Returns: void
+    Purpose: Take any snapshot armed for the frame that was just presented.
+*/
+void ScreenProxy::onFrame()
+{
+    for (size_t i = 0; i < uiFrameSnapshots.size(); ) {
+        if (uiFrameSnapshots[i].first == frames) {
+            uiSnapshot(uiFrameSnapshots[i].second);
+            uiFrameSnapshots.erase(uiFrameSnapshots.begin() + i);
+        } else ++i;
+    }
+}
+
+/*
+    Function: uiCloseStep
+    Inputs: none
+    Returns: void
+    Purpose: Finish measuring the current tap and check it against its budget.
+*/
+void uiCloseStep()
+{
+    if (!uiStepOpen) return;
+    uiStepOpen = false;
+    UiStepResult &r = uiResults.back();
+    r.frames = Screen.frames - uiFrames0;
+    r.drawCalls = Screen.drawCalls - uiDraws0;
+    r.ms = virtualNowMs - uiStart0;
+    const UiStep &st = uiSteps[uiStepPos - 1];
+    if ((st.maxFrames >= 0 && r.frames > st.maxFrames) || (st.maxMs >= 0 && r.ms > st.maxMs)) {
+        r.ok = false;
+        uiFailed = true;
+    }
+}
+
+/*
+    Function: uiFinish
+    Inputs: none
+    Returns: void (does not return)
+    Purpose: Print the per-step report and exit with status 1 if anything failed.
+*/
+void uiFinish()
+{
+    uiCloseStep();
+    printf("%-14s %8s %10s %10s\n", "step", "frames", "drawcalls", "ms");
+    for (auto &r : uiResults) {
+        printf("%-14s %8ld %10ld %10lld%s\n", r.name.c_str(), r.frames, r.drawCalls, r.ms, r.ok ? "" : "  FAIL");
+    }
+    printf("touch-to-photon latency: %s\n", latencySummary().c_str());
+    printf("frame watchdog: %ld overruns\n", watchdog.overruns);
+    printf("golden diff: %.0f comparisons/s (%dx%d)\n", diffThroughput(Screen.shadow), SCREEN_W, SCREEN_H);
+    printf("startup: %s\n", startupTimeline().c_str());
+    for (int b = 0; b < LATENCY_BUCKETS; ++b) {
+        if (Screen.latency.buckets[b] == 0) continue;
+        if (b == LATENCY_BUCKETS - 1) printf("  >=%4d ms: %ld\n", b * LATENCY_BUCKET_MS, Screen.latency.buckets[b]);
+        else printf("  %4d-%4d ms: %ld\n", b * LATENCY_BUCKET_MS, (b + 1) * LATENCY_BUCKET_MS - 1, Screen.latency.buckets[b]);
+    }
+    printf("%s: %zu steps, %lld ms virtual\n", uiFailed ? "FAILED" : "PASSED", uiResults.size(), virtualNowMs);
+    exit(uiFailed ? 1 : 0);
+}
+
+/*
+    Function: uiOnIdle
+    Inputs: none
+    Returns: void
+    Purpose: Called while the game waits for a fresh press: check expectations, then deliver the next tap.
+*/
+void uiOnIdle()
+{
+    while (uiStepPos < uiSteps.size() && !uiSteps[uiStepPos].isTap) {
+        const UiStep &st = uiSteps[uiStepPos++];
+        if (st.name == "snapshot") {
+            if (st.atFrame == 0) uiSnapshot(st.text);
+            continue; // frame snapshots were armed when their tap was delivered
+        }
+        bool seen = false;
+        for (auto &t : Screen.text) if (t.find(st.text) != string::npos) seen = true;
+        if (!seen) {
+            printf("expect failed: \"%s\"\n", st.text.c_str());
+            uiFailed = true;
+            if (!uiResults.empty()) uiResults.back().ok = false;
+        }
+    }
+    if (uiStepPos >= uiSteps.size()) uiFinish();
+
+    uiCloseStep();
+    const UiStep &st = uiSteps[uiStepPos++];
+    touchScript.push_back({virtualNowMs, virtualNowMs + 50, st.x, st.y});
+    uiResults.push_back({st.name, 0, 0, 0, true});
+    uiStepOpen = true;
+    uiFrames0 = Screen.frames; uiDraws0 = Screen.drawCalls; uiStart0 = virtualNowMs;
+
+    // arm snapshots that must be taken mid-flow, counted in frames from this tap
+    for (size_t i = uiStepPos; i < uiSteps.size() && !uiSteps[i].isTap; ++i) {
+        if (uiSteps[i].name == "snapshot" && uiSteps[i].atFrame > 0)
+            uiFrameSnapshots.push_back({Screen.frames + uiSteps[i].atFrame, uiSteps[i].text});
+    }
+}
+#endif
+
+long long idleSleptMs = 0; // time spent in IdleSleep between touch polls
+
+/*
+    Function: IdleSleep
+    Inputs: int ms - milliseconds to sleep
+    Returns: void
+    Purpose: Sleep between touch polls while waiting for input. Unlike SleepMs this is not pacing, so
+             automation builds still see consecutive polls as "the game is waiting for a press".
+*/
+void IdleSleep(int ms)
+{
+#ifdef MINIMON_PROFILE
+    if (profileStopRequested) exit(0); // Ctrl+C: leave through exit() so profileDump runs
+#endif
+    if (watchdog.idleDepth == 0) watchdog.idleMs += ms;
+    idleSleptMs += ms;
+#ifdef MINIMON_VIRTUAL_CLOCK
+    virtualNowMs += ms;
+#else
+    Sleep(ms);
+#endif
+}
+
+/*
+    Function: SleepMs
+    Inputs: int ms - milliseconds to sleep
+    Returns: void
+    Purpose: Sleep can either take input in ms or s; this ensures ms usage throughout the project
+    Author: Pranav Rajesh
+*/
+void SleepMs(int ms) 
+{ 
+    IdleSleep(ms);
+    idleSleptMs -= ms; // pacing delay, not waiting for input
+#ifdef MINIMON_AUTOMATION
+    uiIdlePolls = 0;
+#endif
+}
+
+/*
+    Function: NowMs
+    Inputs: none
+    Returns: long long - current time in milliseconds (virtual time in virtual-clock builds)
+    Purpose: Single time source for anything that measures durations. Also leaves the reading in
+             flightClockMs for the flight recorder.
+*/
+long long NowMs()
+{
+#ifdef MINIMON_VIRTUAL_CLOCK
+    long long now = virtualNowMs;
+#else
+    long long now = (long long)(TimeNow() * 1000.0);
+#endif
+    flightClockMs = (uint32_t)now;
+    return now;
+}
+
+#ifdef MINIMON_VIRTUAL_CLOCK
+/*
+    Function: virtualTouch
+    Inputs: int &x, int &y (by reference) - touch coordinates if touching
+    Returns: bool (true while a scripted touch is down)
+    Purpose: Touch source of virtual-clock builds: the touch script at the current virtual time.
+*/
+bool virtualTouch(int &x, int &y)
+{
+    virtualNowMs += VIRTUAL_POLL_MS; // a poll takes time, so busy waits still move the clock
+    while (touchScriptPos < touchScript.size() && touchScript[touchScriptPos].endMs <= virtualNowMs) touchScriptPos++;
+#ifdef MINIMON_AUTOMATION
+    // two idle polls in a row without a sleep between them means the game is waiting for a press
+    bool scripted = touchScriptPos < touchScript.size() && touchScript[touchScriptPos].startMs <= virtualNowMs;
+    if (!scripted && ++uiIdlePolls >= 2) { uiIdlePolls = 0; uiOnIdle(); }
+#endif
+    if (touchScriptPos < touchScript.size()) {
+        const TouchEvent &e = touchScript[touchScriptPos];
+        if (e.startMs > virtualNowMs) return false;
+        x = e.x; y = e.y;
+        return true;
+    }
+    long long scriptEnd = touchScript.empty() ? 0 : touchScript.back().endMs;
+    if (virtualNowMs > scriptEnd + VIRTUAL_IDLE_LIMIT_MS) virtualScriptFinished();
+    return false;
+}
+#endif
+
+bool wasTouching = false; // touch state at the previous poll, to find the moment a touch goes down
+
+/*
+    Function: ReadTouch
+    Inputs: int &x, int &y (by reference) - touch coordinates if touching
+    Returns: bool (true while the screen is touched)
+    Purpose: Single touch source; reads the touch screen, or the touch script in virtual-clock builds.
+             Also starts the touch-to-photon latency timer whenever a touch goes down.
+*/
+bool ReadTouch(int &x, int &y)
+{
+#ifdef MINIMON_VIRTUAL_CLOCK
+    bool touching = virtualTouch(x, y);
+#else
+    bool touching = LCD.Touch(&x, &y);
+#endif
+    if (touching && !wasTouching) {
+        Screen.TouchDown(x, y, NowMs());
+        flightRecord(FR_TOUCH, x, y);
+    }
+    wasTouching = touching;
+    return touching;
+}
+
+
+// ----------------------------- IDLE MANAGER -----------------------------
+// Touch waits poll every IDLE_TICK_MS and sleep in between instead of spinning; after
+// IDLE_SLOW_AFTER_MS without input the poll rate drops to one per IDLE_SLOW_TICK_MS. The main menu
+// switches to a dimmed attract screen after ATTRACT_AFTER_MS and redraws it only once per
+// ATTRACT_FRAME_MS. The longest tick is still well under a tap, so no press is missed.
+const int IDLE_TICK_MS = 10;
+const int IDLE_SLOW_TICK_MS = 40;
+const int IDLE_SLOW_AFTER_MS = 3000;
+const int ATTRACT_AFTER_MS = 60000;
+const int ATTRACT_FRAME_MS = 2000;
+const int PARKED_TICK_MS = 60000;
+const unsigned int DIM_GRAY = 0x303030;
+long long lastInputMs = 0; // last time a touch was seen (set to the end of startup by finishStartup)
+
+/*
+    Function: PollTouchIdle
+    Inputs: int &x, int &y (by reference) - touch coordinates if touching
+    Returns: bool (true if the screen is touched)
+    Purpose: One poll of a touch wait: read the touch, otherwise sleep for the current idle tick.
+*/
+bool PollTouchIdle(int &x, int &y)
+{
+    if (ReadTouch(x, y)) { lastInputMs = NowMs(); return true; }
+    IdleSleep(NowMs() - lastInputMs > IDLE_SLOW_AFTER_MS ? IDLE_SLOW_TICK_MS : IDLE_TICK_MS);
+    return false;
+}
+
+/*
+    Function: WaitWhileTouched
+    Inputs: none
+    Returns: void
+    Purpose: Wait for the finger to lift, polling at the active tick.
+*/
+void WaitWhileTouched()
+{
+    int x, y;
+    while (ReadTouch(x, y)) IdleSleep(IDLE_TICK_MS);
+    lastInputMs = NowMs();
+}
+
+/*
+    Function: WaitForTouchRelease
+    Inputs: none
+    Returns: void
+    Purpose: Wait until no touch is present; used to debounce and avoid ghost touches.
+    Author: Pranav Rajesh
+*/
+void WaitForTouchRelease()
+{
+    WaitIdle idle;
+    WaitWhileTouched();
+    SleepMs(BUTTON_DEBOUNCE_MS);
+}
+
+/*
+    Function: WaitForCleanPress
+    Inputs: int &outX, int &outY (by reference) - returns the touch coordinates
+    Returns: void
+    Purpose: Wait for release, then wait for new press, capture coords, wait for release again.
+    Author: Pranav Rajesh
+*/
+void WaitForCleanPress(int &outX, int &outY)
+{
+    WaitIdle idle;
+    int x, y;
+    // ensure no current touch
+    WaitWhileTouched();
+    SleepMs(BUTTON_DEBOUNCE_MS);
+
+    // wait for touch
+    while (!PollTouchIdle(x, y)) {}
+    outX = x; outY = y;
+
+    // wait for release
+    WaitWhileTouched();
+    SleepMs(BUTTON_DEBOUNCE_MS);
+}
+
+// RNG state: xoshiro128** (four 32-bit words). Much cheaper than std::rand on the device,
+// and the whole stream position is just these words, so checkpoints can save and restore it exactly.
+uint32_t rngState[4] = { 1, 2, 3, 4 };
+
+/*
+    Function: seedRandom
+    Inputs: uint32_t seed
+    Returns: void
+    Purpose: Expand a single seed into the four generator words using splitmix32
+             (xoshiro must never be seeded with all zeros).
+*/
+void seedRandom(uint32_t seed)
+{
+    for (int i = 0; i < 4; ++i) {
+        seed += 0x9E3779B9u;
+        uint32_t z = seed;
+        z = (z ^ (z >> 16)) * 0x85EBCA6Bu;
+        z = (z ^ (z >> 13)) * 0xC2B2AE35u;
+        rngState[i] = z ^ (z >> 16);
+    }
+    if ((rngState[0] | rngState[1] | rngState[2] | rngState[3]) == 0) rngState[0] = 1;
+}
+
+/*
+    Function: nextRandom
+    Inputs: none
+    Returns: uint32_t - next raw 32-bit value of the stream
+    Purpose: One xoshiro128** step.
+*/
+uint32_t nextRandom()
+{
+    uint32_t x = rngState[1] * 5;
+    uint32_t result = ((x << 7) | (x >> 25)) * 9;
+    uint32_t t = rngState[1] << 9;
+    rngState[2] ^= rngState[0];
+    rngState[3] ^= rngState[1];
+    rngState[1] ^= rngState[2];
+    rngState[0] ^= rngState[3];
+    rngState[2] ^= t;
+    rngState[3] = (rngState[3] << 11) | (rngState[3] >> 21);
+    return result;
+}
+
+/*
+    Function: randInt
+    Inputs: int a, int b - inclusive range
+    Returns: random integer in [a,b]
+    Purpose: Convenience random integer generator, making this a function makes the code much more readable. 
+             Uses multiply-shift range reduction (with rejection of the few biased values) instead of %,
+             so every value in the range is equally likely.
+    Author: Aadit Bhatia
+*/
+int randInt(int a, int b) 
+{ 
+    uint32_t range = (uint32_t)(b - a + 1);
+    uint64_t m = (uint64_t)nextRandom() * range;
+    uint32_t low = (uint32_t)m;
+    if (low < range) {
+        uint32_t threshold = (0u - range) % range;
+        while (low < threshold) {
+            m = (uint64_t)nextRandom() * range;
+            low = (uint32_t)m;
+        }
+    }
+    return a + (int)(m >> 32);
+}
+
+// ----------------------------- UI: Menu (comment blocks) -----------------------------
+/*
+    Function: DrawMenuButton
+    Inputs: const char* label, int index (0-based)
+    Returns: void
+    Purpose: Draw a menu rectangle and label at the given index (vertical). This is what is used to create the buttons on the main menu
+    Author: Aadit Bhatia
+*/
+void DrawMenuButton(const char* label, int index)
+{
+    int y = BTN_START_Y + index * (BTN_H + BTN_GAP);
+    Screen.DrawRectangle(BTN_X, y, BTN_W, BTN_H);
+    Screen.WriteAt(label, BTN_X + 10, y + 12);
+}
+
+/*
+    Function: DrawMainMenu
+    Inputs: none
+    Returns: void
+    Purpose: Draw the full main menu UI. This function uses DrawMenuButton to create each button on the main menu, plus adding a title and background. 
+    Author: Aadit Bhatia
+*/
+void DrawMainMenu()
+{
+    Screen.Clear(BLACK);
+    Screen.SetFontColor(WHITE);
+    Screen.WriteAt("POKÉMON MINI (SDP)", BTN_X, 10);
+
+    DrawMenuButton("1. Play", 0);
+    DrawMenuButton("2. Instructions", 1);
+    DrawMenuButton("3. Statistics", 2);
+    DrawMenuButton("4. Credits", 3);
+
+    Screen.Update();
+}
+
+/*
+    Function: HighlightMenuButton
+    Inputs: int index (0-based)
+    Returns: void
+    Purpose: Visually highlight a menu button briefly for feedback. This makes the game more accessible for those with visual impairments.
+    Author: Aadit Bhatia
+*/
+void HighlightMenuButton(int index)
+{
+    if (index < 0 || index >= NUM_MENU_BUTTONS) return;
+    int y = BTN_START_Y + index * (BTN_H + BTN_GAP);
+    Screen.SetFontColor(BLACK);
+    Screen.FillRectangle(BTN_X, y, BTN_W, BTN_H);
+    Screen.SetFontColor(WHITE);
+    //breaks needed so each case doesn't play in order
+    switch(index) {
+        case 0: Screen.WriteAt("1. Play", BTN_X + 10, y + 12); break;
+        case 1: Screen.WriteAt("2. Instructions", BTN_X + 10, y + 12); break;
+        case 2: Screen.WriteAt("3. Statistics", BTN_X + 10, y + 12); break;
+        case 3: Screen.WriteAt("4. Credits", BTN_X + 10, y + 12); break;
+    }
+    Screen.Update();
+    SleepMs(160);
+}
+
+/*
+    Function: RunAttractScreen
+    Inputs: none
+    Returns: void (once the screen is touched)
+    Purpose: Dimmed idle screen: a dark background with the title drifting to a new spot every
+             ATTRACT_FRAME_MS, polling at the slow tick in between.
+*/
+void RunAttractScreen()
+{
+    int x, y;
+    for (int frame = 0; ; ++frame) {
+        watchdogCreditIdle(); // the wait since the last attract frame is idle, not frame time
+        Screen.Clear(BLACK);
+        Screen.SetFontColor(DIM_GRAY);
+        Screen.WriteAt("Minimon - tap to play", 10 + (frame * 37) % 60, 30 + (frame * 53) % 180);
+        Screen.Update();
+        long long until = NowMs() + ATTRACT_FRAME_MS;
+        while (NowMs() < until) if (PollTouchIdle(x, y)) return;
+    }
+}
+
+/*
+    Function: GetMenuButtonPressed
+    Inputs: none
+    Returns: int (1..NUM_MENU_BUTTONS) or 0 if invalid
+    Purpose: Read a touch and map it robustly to the menu buttons. Recieves whatever button the user pressed based on x,y coords, and maps it to a predetermined
+    menu button. 
+    Author: Aadit Bhatia
+*/
+int GetMenuButtonPressed()
+{
+    WaitIdle idle;
+    int x,y;
+    // wait for touch; after a long idle stretch show the attract screen, and let the wake-up tap
+    // only bring the menu back (0 = nothing chosen, the caller redraws)
+    while (!PollTouchIdle(x, y)) {
+        if (NowMs() - lastInputMs >= ATTRACT_AFTER_MS) {
+            RunAttractScreen();
+            WaitForTouchRelease();
+            return 0;
+        }
+    }
+    int touchX = x, touchY = y;
+    WaitForTouchRelease();
+
+    // filter horizontally
+    if (touchX < BTN_X || touchX > (BTN_X + BTN_W)) return 0;
+
+    int rel = touchY - BTN_START_Y;
+    if (rel < 0) return 0;
+    int rowH = BTN_H + BTN_GAP;
+    int index = rel / rowH;
+    if (index >= 0 && index < NUM_MENU_BUTTONS) {
+        int top = BTN_START_Y + index * rowH;
+        int bottom = top + BTN_H;
+        if (touchY >= top && touchY <= bottom) return index + 1;
+    }
+    return 0;
+}
+
+// ----------------------------- OOP CLASSES (with comment blocks) -----------------------------
+/*
+    Class: Move
+    Members:
+      - string name: human-readable move name
+      - int power: a base power used in damage calculation
+      - int accuracy: percentage 0..100
+      - int pp: number of times move can be used
+    Author: Aadit Bhatia
+*/
+struct Move {
+    string name;
+    int power;
+    int accuracy;
+    int pp;
+};
+
+/*
+    Class: Pokemon
+    Members:
+      - string name
+      - int maxHP, hp
+      - int attack, defense
+      - vector<Move> moves
+      - int x,y,w,h : drawn bounding box (used for simple sprite and collisions)
+      - bool defending : whether defend is active
+      - const SpriteAsset *sprite, int color : art, resolved when the Pokémon is picked for a match
+    Methods:
+      - reset() : restores hp and clears defend
+    Author: Aadit Bhatia
+*/
+struct Pokemon {
+    string name;
+    int maxHP;
+    int hp;
+    int attack;
+    int defense;
+    vector<Move> moves;
+    int x, y, w, h; // for drawing / collision
+    bool defending;
+    const SpriteAsset *sprite; // nullptr until loadArt() runs
+    int color;
+    void reset() { hp = maxHP; defending = false; for(auto &m : moves) if (m.pp < 0) m.pp = 0; }
+    bool fainted() const { return hp <= 0; }
+};
+
+/*
+    Class: Player
+    Members:
+      - string label ("Player 1"/"Player 2")
+      - bool isHuman
+      - Pokemon pkmn
+      - int wins (session stat)
+    Author: Pranav Rajesh
+*/
+struct Player {
+    string label;
+    bool isHuman;
+    Pokemon pkmn;
+    int wins;
+    Player(): wins(0) {}
+};
+
+#ifdef MINIMON_FUZZ
+// Projectile stub for the fuzzer: -1 animates as usual; 0 or 1 decides without drawing whether the
+// projectile reaches the target, so resolveAction's ACT_NO_HIT branch can be fuzzed headless.
+int fuzzProjectile = -1;
+#endif
+
+/*
+    Class: Game
+    Members:
+      - vector<Pokemon> bank : available Pokémon
+      - Player p1, p2
+      - int gamesPlayed, humanWins, cpuWins
+      - int difficulty (0=Easy,1=Hard)
+    Methods:
+      - loadBank() : populates bank with Pokemon to be randomly chosen
+      - finishStartup() : deferred init (bank, session snapshot), run once the menu is up
+      - setupMatch(difficulty) : assigns players/mon
+      - runMatch() : runs a single match loop and returns whether to replay
+    Author: Aadit Bhatia and Pranav Rajesh
+    Outside Sources: Learned C++ Lambda Functions from W3Schools + my dad uses them for AWS work so he explained the logic to me
+    Also learned vectors(dynamic arrays) from W3Schools.
+*/
+class Game {
+public:
+    vector<Pokemon> bank;
+    Player p1, p2;
+    int gamesPlayed;
+    int humanWins;
+    int cpuWins;
+    int difficulty; // 0 easy, 1 hard
+
+    // cache for koDistribution results: KO_CACHE_SETS sets of KO_CACHE_WAYS entries, picked by a hash of
+    // the key. The key holds every stat the answer depends on, so an edited species can never hit a
+    // stale entry; a full set evicts its least recently used entry.
+    struct KoKey {
+        int atk, def, hp, power, accuracy, uses, ppCap, diff;
+        bool defending;
+        bool operator==(const KoKey &o) const
+        {
+            return atk == o.atk && def == o.def && hp == o.hp && power == o.power && accuracy == o.accuracy &&
+                   uses == o.uses && ppCap == o.ppCap && diff == o.diff && defending == o.defending;
+        }
+    };
+    struct KoCacheEntry {
+        KoKey key;
+        bool valid;
+        uint32_t lastUse;
+        vector<double> dist;
+    };
+    static const int KO_CACHE_SETS = 16;
+    static const int KO_CACHE_WAYS = 4;
+    vector<KoCacheEntry> koCache;
+    uint32_t koCacheTick;
+
+#ifdef MINIMON_BALANCE
+    // matchup matrix (balance tool only): matchup[i*N + j] = chance species i knocks out species j within
+    // MATCHUP_HITS uses. Each cell remembers the content hashes it was computed from; only cells whose
+    // hashes changed are redone.
+    struct MatchupCell {
+        uint32_t attHash, defHash;
+        bool valid;
+        double chance;
+    };
+    vector<MatchupCell> matchup;
+#endif
+
+    // static battle background, built once (see buildBackgroundLayer)
+    struct BgPrim {
+        int x, y, w, h;
+        unsigned int color;
+        bool filled;
+    };
+    vector<BgPrim> bgLayer;
+
+    // battle screen compositor. The screen is built from layers, bottom to top:
+    // background, status panel, Pokémon graphics, effects (projectile), battle buttons.
+    // Changes mark dirty rectangles and composite() repaints just those rectangles, layer by layer.
+    enum Layer { LAYER_BACKGROUND, LAYER_STATUS, LAYER_SPRITES, LAYER_EFFECTS, LAYER_BUTTONS };
+    struct BattleButton {
+        int x,y,w,h; string label; int id;
+    };
+    static const int NUM_BATTLE_BTNS = 4;
+    BattleButton btns[NUM_BATTLE_BTNS];
+    int highlightBtn;   // button drawn highlighted, -1 for none
+    bool fxActive;      // projectile on screen
+    Rect fxRect;        // where the projectile is drawn
+    vector<Rect> dirty;
+    // outcome of one battle action (see resolveAction)
+    enum ActionOutcome { ACT_NONE, ACT_RETREAT, ACT_NO_PP, ACT_DEFEND, ACT_MISS, ACT_HIT, ACT_NO_HIT };
+    struct ActionResult {
+        ActionOutcome outcome;
+        int damage;
+    };
+    // one line of status panel text
+    struct StatusLine {
+        string text;
+        int x, y;
+    };
+
+#ifdef MINIMON_BALANCE
+    // one entry of a stat sensitivity report: which stat, and how much the matchup cell moves when the stat
+    // is raised or lowered by one. A direction that would take the stat out of its legal range is not probed.
+    struct StatSensitivity {
+        string label;
+        double up, down;
+        bool canRaise, canLower;
+        double effect() const
+        {
+            double u = canRaise ? (up < 0 ? -up : up) : 0.0, d = canLower ? (down < 0 ? -down : down) : 0.0;
+            return u > d ? u : d;
+        }
+    };
+#endif
+
+    bool resumeSession; // finishStartup restores the checkpoint (normal runs) instead of keeping the caller's seed
+    bool startupDone;
+
+    // cheap on purpose: everything else waits for finishStartup so the menu comes up first
+    Game(): gamesPlayed(0), humanWins(0), cpuWins(0), difficulty(0),
+            koCache(KO_CACHE_SETS * KO_CACHE_WAYS, KoCacheEntry()), koCacheTick(0), highlightBtn(-1), fxActive(false),
+            resumeSession(false), startupDone(false) {}
+
+    /*
+        Function: finishStartup
+        Inputs: none
+        Returns: void
+        Purpose: Deferred startup work: load the bank and, for normal runs, restore the session snapshot
+                 (or seed a fresh random stream). Runs once; mainMenuLoop calls it after the first menu frame.
+    */
+    void finishStartup()
+    {
+        if (startupDone) return;
+        loadBank();
+        startupMark("bank");
+        if (resumeSession) {
+            if (!loadCheckpoint()) seedRandom((uint32_t)std::time(nullptr));
+            startupMark("snapshot");
+        }
+        // idle time counts from the end of startup, not from the clock's epoch: otherwise a clock
+        // that does not start near zero makes the first menu idle (or attract) straight away
+        lastInputMs = NowMs();
+        startupDone = true;
+    }
+
+    // loadBank: fill bank with sample Pokémon (stats simplified)
+    //Author: Aadit Bhatia
+    void loadBank()
+    {
+        bank.clear();
+        // create helper lambda for moves
+        //used a lambda function to reduce code duplication and make it easier to read
+        auto mk = [](const string &n, int hp, int atk, int def,
+                     const Move &m1, const Move &m2, const Move &m3) -> Pokemon {
+            Pokemon p; p.name = n; p.maxHP = hp; p.hp = hp; p.attack = atk; p.defense = def;
+            p.moves = { m1, m2, m3 };
+            p.w = 48; p.h = 48; p.x = 0; p.y = 0; p.defending = false;
+            p.sprite = nullptr; p.color = WHITE; // art is loaded lazily by loadArt
+            return p;
+        };
+        bank.push_back(mk("Pikachu", 40, 11, 6, Move{"Thunder",40,95,15}, Move{"Quick",40,100,20}, Move{"Growl",0,100,25}));
+        bank.push_back(mk("Charmander",45,10,7, Move{"Ember",40,95,15}, Move{"Scratch",35,100,25}, Move{"Tail",0,100,25}));
+        bank.push_back(mk("Squirtle",50,9,9, Move{"Water",40,95,15}, Move{"Tackle",40,100,25}, Move{"Withdraw",0,100,25}));
+        bank.push_back(mk("Bulbasaur",48,9,8, Move{"Vine",45,100,15}, Move{"Tackle",40,100,25}, Move{"Seed",0,90,20}));
+        bank.push_back(mk("Gengar",55,12,6, Move{"Shadow",50,90,12}, Move{"Lick",30,95,20}, Move{"Hypno",0,70,8}));
+        bank.push_back(mk("Onix",60,11,12, Move{"RockT",50,90,15}, Move{"Tackle",40,100,25}, Move{"Harden",0,100,20}));
+    }
+
+    /*
+        Function: assignPlayers
+        Inputs: none
+        Returns: void
+        Purpose: Randomly decides who is human vs CPU, picks two distinct Pokémon from bank,
+                 positions them for drawing on the screen, sets difficulty-dependent seed if needed.
+        Author: Pranav Rajesh
+    */
+    void assignPlayers()
+    {
+        // randomize who is human: for this project we assign Player1 as human always for clarity,
+        // or flip randomly — we'll flip randomly to satisfy random generation requirement
+        int assignment = randInt(0,1);
+        if (assignment == 0) { p1.isHuman = true; p2.isHuman = false; }
+        else                 { p1.isHuman = false; p2.isHuman = true; }
+
+        p1.label = "Player 1";
+        p2.label = "Player 2";
+
+        // pick two distinct indices
+        // used randInt function to improve readability
+        // ensure different Pokémon, should be virtually random.
+        int i1 = randInt(0, (int)bank.size()-1);
+        int i2 = randInt(0, (int)bank.size()-1);
+        while (i2 == i1) i2 = randInt(0, (int)bank.size()-1);
+
+        p1.pkmn = bank[i1];
+        p2.pkmn = bank[i2];
+        p1.pkmn.reset(); p2.pkmn.reset();
+
+        // load art for just the two picked species, so drawing never looks anything up
+        loadArt(p1.pkmn); loadArt(p2.pkmn);
+
+        // set drawing positions (left/right)
+        p1.pkmn.x = 40; p1.pkmn.y = 60; // left
+        p2.pkmn.x = 220; p2.pkmn.y = 60; // right
+    }
+
+    /*
+        Function: damageForRoll
+        Inputs: const Pokemon &att, const Pokemon &def, const Move &m, int roll (DAMAGE_ROLL_MIN..DAMAGE_ROLL_MAX)
+        Returns: int damage value
+        Purpose: The deterministic part of the damage formula for one multiplier roll.
+                 Shared by computeDamage and koChance so both always agree.
+        Author: Pranav Rajesh
+    */
+    int damageForRoll(const Pokemon &att, const Pokemon &def, const Move &m, int roll)
+    {
+        double base = (double)att.attack - ((double)def.defense * 0.45);
+        if (base < 1.0) base = 1.0;
+        double raw = base * (m.power / 20.0);
+        double mult = (roll / 100.0);
+        // difficulty modifies multiplier: Hard increases CPU damage a bit (we do symmetric effect)
+        if (difficulty == 1) raw *= 1.08;
+        raw *= mult;
+        int dmg = (int)(raw + 0.5);
+        if (dmg < MIN_DAMAGE) dmg = MIN_DAMAGE;
+        return dmg;
+    }
+
+    /*
+        Function: computeDamage
+        Inputs: const Pokemon &att, const Pokemon &def, const Move &m
+        Returns: int damage value
+        Purpose: Compute damage value based on simple formula and difficulty modifier
+        Author: Pranav Rajesh
+
+    */
+    int computeDamage(const Pokemon &att, const Pokemon &def, const Move &m)
+    {
+        int roll = randInt(DAMAGE_ROLL_MIN, DAMAGE_ROLL_MAX);
+        flightRecord(FR_ROLL, 1, roll);
+        return damageForRoll(att, def, m, roll);
+    }
+
+    /*
+        Function: koDistribution
+        Inputs: const Pokemon &att, const Pokemon &def, const Move &m, int hits (attempts),
+                bool defending (def is currently defending, so the first landed hit is halved)
+        Returns: vector<double> - element k-1 is the chance def is knocked out on exactly attempt k
+                 (k = 1..hits); what is left over is the chance def survives every attempt
+        Purpose: Exact N-hit KO distribution of att's move m against def at its current HP, including accuracy
+                 misses, the damage roll, defend halving and the move's remaining PP (only landed hits use PP).
+                 Dynamic programming over the defender's remaining HP, so it is exact and needs no sampling.
+                 Results are cached per matchup (see koCache).
+    */
+    vector<double> koDistribution(const Pokemon &att, const Pokemon &def, const Move &m, int hits,
+                                  bool defending = false)
+    {
+        // a missed attack does not use PP, so PP limits landed hits rather than attempts
+        int uses = hits < 0 ? 0 : hits;
+        int ppCap = uses < m.pp ? uses : m.pp;
+        KoKey key = {att.attack, def.defense, def.hp, m.power, m.accuracy, uses, ppCap, difficulty, defending};
+
+        uint32_t h32 = 2166136261u;
+        for (int v : {key.atk, key.def, key.hp, key.power, key.accuracy, key.uses, key.ppCap, key.diff, (int)key.defending})
+            h32 = (h32 ^ (uint32_t)v) * 16777619u;
+        KoCacheEntry *set = &koCache[(h32 % KO_CACHE_SETS) * KO_CACHE_WAYS];
+        KoCacheEntry *slot = &set[0];
+        for (int w = 0; w < KO_CACHE_WAYS; ++w) {
+            if (set[w].valid && set[w].key == key) { set[w].lastUse = ++koCacheTick; return set[w].dist; }
+            if (!set[w].valid) { if (slot->valid) slot = &set[w]; }
+            else if (slot->valid && set[w].lastUse < slot->lastUse) slot = &set[w];
+        }
+        slot->key = key;
+        slot->valid = true;
+        slot->lastUse = ++koCacheTick;
+        vector<double> &out = slot->dist;
+        out.assign(uses, 0.0);
+        if (def.hp <= 0) { if (uses > 0) out[0] = 1.0; return out; }
+        if (ppCap <= 0 || m.power == 0) return out;
+
+        // damage of every roll, normal and halved by defend (rolls are equally likely)
+        const int NUM_ROLLS = DAMAGE_ROLL_MAX - DAMAGE_ROLL_MIN + 1;
+        int dmg[NUM_ROLLS], dmgHalf[NUM_ROLLS];
+        for (int r = 0; r < NUM_ROLLS; ++r) {
+            dmg[r] = damageForRoll(att, def, m, DAMAGE_ROLL_MIN + r);
+            dmgHalf[r] = (dmg[r] + 1) / 2;
+        }
+        int acc = m.accuracy > 100 ? 100 : (m.accuracy < 0 ? 0 : m.accuracy);
+        double pHit = acc / 100.0, pMiss = 1.0 - pHit, pRoll = pHit / NUM_ROLLS;
+
+        // dist[(d, l, h)]: probability the defender is still standing with h HP after l landed hits,
+        // with d = 1 while the defend bonus is still waiting for a hit to absorb.
+        // Knockouts in attempt u go to out[u]; paths that run out of PP can never knock out and are dropped.
+        int hp = def.hp;
+        auto at = [hp, ppCap](int d, int l, int h) { return ((d * ppCap) + l) * (hp + 1) + h; };
+        vector<double> dist(2 * ppCap * (hp + 1), 0.0), next(dist.size(), 0.0);
+        dist[at(defending ? 1 : 0, 0, hp)] = 1.0;
+
+        for (int u = 0; u < uses; ++u) {
+            std::fill(next.begin(), next.end(), 0.0);
+            for (int d = 0; d < 2; ++d) {
+                const int *table = d ? dmgHalf : dmg;
+                for (int l = 0; l < ppCap; ++l) {
+                    for (int h = 1; h <= hp; ++h) {
+                        double p = dist[at(d, l, h)];
+                        if (p == 0.0) continue;
+                        next[at(d, l, h)] += p * pMiss;
+                        for (int r = 0; r < NUM_ROLLS; ++r) {
+                            int left = h - table[r];
+                            if (left <= 0) out[u] += p * pRoll;
+                            else if (l + 1 < ppCap) next[at(0, l + 1, left)] += p * pRoll;
+                        }
+                    }
+                }
+            }
+            dist.swap(next);
+        }
+        return out;
+    }
+
+    /*
+        Function: koChance
+        Inputs: const Pokemon &att, const Pokemon &def, const Move &m, int hits, bool defending
+        Returns: double probability in [0,1]
+        Purpose: Chance that att knocks out def within `hits` attempts with m (the sum of koDistribution).
+    */
+    double koChance(const Pokemon &att, const Pokemon &def, const Move &m, int hits, bool defending = false)
+    {
+        double chance = 0.0;
+        for (double p : koDistribution(att, def, m, hits, defending)) chance += p;
+        return chance;
+    }
+
+    /*
+        Function: clearKoCache
+        Inputs: none
+        Returns: void
+        Purpose: Forget every cached distribution (benchmarks use it to time the solver itself).
+    */
+    void clearKoCache()
+    {
+        for (auto &e : koCache) e.valid = false;
+    }
+
+#ifdef MINIMON_BALANCE
+    /*
+        Function: speciesHash
+        Inputs: const Pokemon &p
+        Returns: uint32_t content hash (FNV-1a) of the species' name, stats and moves, plus the difficulty
+        Purpose: Key for the matchup matrix; any stat edit gives the species a new hash.
+    */
+    uint32_t speciesHash(const Pokemon &p)
+    {
+        uint32_t h = 2166136261u;
+        auto mix = [&h](int v) {
+            for (int i = 0; i < 4; ++i) { h ^= (uint32_t)((v >> (8 * i)) & 0xFF); h *= 16777619u; }
+        };
+        for (char c : p.name) { h ^= (unsigned char)c; h *= 16777619u; }
+        mix(p.maxHP); mix(p.attack); mix(p.defense); mix(difficulty);
+        for (auto &m : p.moves) {
+            for (char c : m.name) { h ^= (unsigned char)c; h *= 16777619u; }
+            mix(m.power); mix(m.accuracy); mix(m.pp);
+        }
+        return h;
+    }
+
+    /*
+        Function: bestKoChance
+        Inputs: const Pokemon &att, const Pokemon &def, int hits
+        Returns: double - chance att knocks out a full-HP def within `hits` uses of its best move
+        Purpose: Value stored in one matchup matrix cell.
+    */
+    double bestKoChance(const Pokemon &att, const Pokemon &def, int hits)
+    {
+        Pokemon fresh = def;
+        fresh.hp = fresh.maxHP;
+        double best = 0.0;
+        for (auto &m : att.moves) {
+            double c = koChance(att, fresh, m, hits);
+            if (c > best) best = c;
+        }
+        return best;
+    }
+
+    /*
+        Function: refreshMatchups
+        Inputs: int threads
+        Returns: int - number of cells that had to be recomputed
+        Purpose: Bring the bank's N x N matchup matrix up to date. Only cells whose attacker or defender
+                 hash changed since they were computed are redone, so editing one species costs one row
+                 and one column instead of the whole matrix. With several threads the dirty cells are
+                 dealt out round-robin, and each thread solves on its own copy of the game so the KO
+                 caches are never shared.
+    */
+    int refreshMatchups(int threads = 1)
+    {
+        int n = (int)bank.size();
+        if ((int)matchup.size() != n * n) matchup.assign(n * n, MatchupCell{0, 0, false, 0.0});
+
+        vector<uint32_t> hashes(n);
+        for (int i = 0; i < n; ++i) hashes[i] = speciesHash(bank[i]);
+
+        vector<int> dirtyCells;
+        for (int c = 0; c < n * n; ++c) {
+            MatchupCell &cell = matchup[c];
+            if (cell.valid && cell.attHash == hashes[c / n] && cell.defHash == hashes[c % n]) continue;
+            cell.attHash = hashes[c / n]; cell.defHash = hashes[c % n];
+            cell.valid = true;
+            dirtyCells.push_back(c);
+        }
+        auto solve = [this, n](Game &solver, const vector<int> &cells, size_t first, size_t step) {
+            for (size_t k = first; k < cells.size(); k += step) {
+                int c = cells[k], i = c / n, j = c % n;
+                matchup[c].chance = (i == j) ? 0.0 : solver.bestKoChance(bank[i], bank[j], MATCHUP_HITS);
+            }
+        };
+        // a thread only pays off with a few cells to solve
+        threads = min(threads, (int)dirtyCells.size() / 4);
+        if (threads > 1) {
+            vector<Game> solvers(threads - 1, *this);
+            vector<std::thread> pool;
+            for (int t = 1; t < threads; ++t)
+                pool.push_back(std::thread(solve, std::ref(solvers[t - 1]), std::cref(dirtyCells), (size_t)t, (size_t)threads));
+            solve(*this, dirtyCells, 0, threads);
+            for (auto &th : pool) th.join();
+            return (int)dirtyCells.size();
+        }
+        solve(*this, dirtyCells, 0, 1);
+        return (int)dirtyCells.size();
+    }
+
+    /*
+        Function: saveMatchupCache
+        Inputs: none
+        Returns: void
+        Purpose: Persist the valid matrix cells (hash pair + value) so the next run starts warm.
+    */
+    void saveMatchupCache()
+    {
+        FEHFile *f = SD.FOpen(MATCHUP_CACHE_FILE, "w");
+        if (f == nullptr) return;
+        for (auto &c : matchup) {
+            if (c.valid) SD.FPrintf(f, "%u %u %.17g\n", (unsigned)c.attHash, (unsigned)c.defHash, c.chance);
+        }
+        SD.FClose(f);
+    }
+
+    /*
+        Function: loadMatchupCache
+        Inputs: none
+        Returns: int - number of cells restored
+        Purpose: Reload cells saved by saveMatchupCache into the matrix positions of species whose
+                 hashes still match; anything else stays dirty for refreshMatchups.
+    */
+    int loadMatchupCache()
+    {
+        FEHFile *f = SD.FOpen(MATCHUP_CACHE_FILE, "r");
+        if (f == nullptr) return 0;
+        int n = (int)bank.size();
+        matchup.assign(n * n, MatchupCell{0, 0, false, 0.0});
+        vector<uint32_t> hashes(n);
+        for (int i = 0; i < n; ++i) hashes[i] = speciesHash(bank[i]);
+
+        int restored = 0;
+        unsigned a, d;
+        double chance;
+        while (SD.FScanf(f, "%u %u %lf", &a, &d, &chance) == 3) {
+            for (int i = 0; i < n; ++i) {
+                if (hashes[i] != a) continue;
+                for (int j = 0; j < n; ++j) {
+                    if (hashes[j] != d) continue;
+                    matchup[i * n + j] = MatchupCell{a, d, true, chance};
+                    restored++;
+                }
+            }
+        }
+        SD.FClose(f);
+        return restored;
+    }
+
+    /*
+        Function: statSensitivity
+        Inputs: int att, int def - bank indices of the matchup
+        Returns: vector<StatSensitivity> sorted by effect size, largest first
+        Purpose: Balance tuning aid. For every stat that feeds the matchup cell (attacker attack and each
+                 move's power/accuracy/PP, defender HP and defense), measure the change in KO chance for +1
+                 and for -1 separately with the exact solver. A stat at the edge of its range (accuracy 100,
+                 PP 0, ...) is only probed in the direction it can move, instead of being clamped into a
+                 zero difference. Neighbouring stat vectors share most of their inputs, so many
+                 evaluations are answered by the KO cache.
+    */
+    vector<StatSensitivity> statSensitivity(int att, int def)
+    {
+        vector<StatSensitivity> out;
+        const Pokemon &a0 = bank[att];
+        const Pokemon &d0 = bank[def];
+        double base = bestKoChance(a0, d0, MATCHUP_HITS);
+
+        // edit(a, d, which, step) applies the nudge and says whether the stat is still in its legal range
+        auto probe = [&](const string &label, bool (*edit)(Pokemon &, Pokemon &, int, int), int which) {
+            StatSensitivity e = {label, 0.0, 0.0, false, false};
+            Pokemon a = a0, d = d0;
+            e.canRaise = edit(a, d, which, 1);
+            if (e.canRaise) e.up = bestKoChance(a, d, MATCHUP_HITS) - base;
+            a = a0; d = d0;
+            e.canLower = edit(a, d, which, -1);
+            if (e.canLower) e.down = bestKoChance(a, d, MATCHUP_HITS) - base;
+            out.push_back(e);
+        };
+
+        probe(a0.name + " attack", [](Pokemon &a, Pokemon &, int, int s) -> bool { a.attack += s; return a.attack >= 1; }, 0);
+        probe(d0.name + " HP", [](Pokemon &, Pokemon &d, int, int s) -> bool { d.maxHP += s; return d.maxHP >= 1; }, 0);
+        probe(d0.name + " defense", [](Pokemon &, Pokemon &d, int, int s) -> bool { d.defense += s; return d.defense >= 0; }, 0);
+        for (int m = 0; m < (int)a0.moves.size(); ++m) {
+            if (a0.moves[m].power == 0) continue; // utility moves never deal damage
+            string mv = a0.name + " " + a0.moves[m].name;
+            probe(mv + " power", [](Pokemon &a, Pokemon &, int i, int s) -> bool {
+                a.moves[i].power += s; return a.moves[i].power >= 1; // power 0 would make it a utility move
+            }, m);
+            probe(mv + " accuracy", [](Pokemon &a, Pokemon &, int i, int s) -> bool {
+                a.moves[i].accuracy += s; return a.moves[i].accuracy >= 0 && a.moves[i].accuracy <= 100;
+            }, m);
+            probe(mv + " PP", [](Pokemon &a, Pokemon &, int i, int s) -> bool { a.moves[i].pp += s; return a.moves[i].pp >= 0; }, m);
+        }
+
+        std::sort(out.begin(), out.end(), [](const StatSensitivity &x, const StatSensitivity &y) {
+            return x.effect() > y.effect();
+        });
+        return out;
+    }
+#endif
+
+    /*
+        Function: getPokemonColor
+        Inputs: const string &name
+        Purpose: Simple utility to assign a color based on the Pokémon name for sprite
+        Author: Aadit Bhatia 
+    */
+    int getPokemonColor(const string &name) {
+        if (name == "Pikachu") return YELLOW;
+        if (name == "Charmander") return RED;
+        if (name == "Squirtle") return BLUE;
+        if (name == "Bulbasaur") return GREEN;
+        if (name == "Gengar") return MAGENTA;
+        if (name == "Onix") return GRAY;
+        return WHITE;
+    }
+
+
+    /*
+        Function: loadArt
+        Inputs: Pokemon &p
+        Returns: void
+        Purpose: Resolve the sprite and tint for a Pokémon once, when it is picked for a match.
+                 Sprites stay RLE-compressed in flash and are decoded during drawing, so loading costs
+                 no RAM beyond a pointer, whatever the size of the bank.
+    */
+    void loadArt(Pokemon &p)
+    {
+        p.sprite = &MON_SPRITE;
+        p.color = getPokemonColor(p.name);
+    }
+
+    /*
+        Function: drawSprite
+        Inputs: const SpriteAsset &s, int x, int y (top-left), int bodyColor, bool flip (mirror horizontally)
+        Returns: void
+        Purpose: Decode an RLE sprite straight onto the screen in one pass per color: body, then black,
+                 then white. A pass paints every stretch of pixels at or above its color that holds at
+                 least one pixel of it (the later passes paint over the rest), and a stretch that repeats
+                 exactly on the next row grows into the same rectangle instead of starting a new one.
+                 Transparent pixels are never drawn so whatever is underneath shows through.
+    */
+    void drawSprite(const SpriteAsset &s, int x, int y, int bodyColor, bool flip)
+    {
+        if (s.cols > SPRITE_MAX_COLS) return;
+        const int palette[4] = { 0, bodyColor, BLACK, WHITE };
+        for (int color = 1; color <= 3; ++color) {
+            SpriteSpan open[SPRITE_MAX_SPANS], next[SPRITE_MAX_SPANS];
+            int numOpen = 0, run = 0;
+            bool penSet = false;
+            for (int row = 0; row <= s.rows; ++row) {
+                int numNext = 0;
+                if (row < s.rows) { // this row's stretches; runs never cross a row
+                    int col = 0, start = -1;
+                    bool needed = false;
+                    while (col < s.cols && run < s.numRuns) {
+                        int len = s.runs[run] >> 2, c = s.runs[run] & 3;
+                        run++;
+                        if (c >= color) {
+                            if (start < 0) { start = col; needed = false; }
+                            needed = needed || c == color;
+                        } else if (start >= 0) {
+                            if (needed) next[numNext++] = {(uint8_t)start, (uint8_t)(col - start), (uint8_t)row};
+                            start = -1;
+                        }
+                        col += len;
+                    }
+                    if (start >= 0 && needed) next[numNext++] = {(uint8_t)start, (uint8_t)(col - start), (uint8_t)row};
+                }
+                // an open rectangle grows if this row repeats its stretch, otherwise it is drawn now
+                for (int i = 0; i < numOpen; ++i) {
+                    int j = 0;
+                    while (j < numNext && (next[j].col != open[i].col || next[j].len != open[i].len)) ++j;
+                    if (j < numNext) { next[j].row0 = open[i].row0; continue; }
+                    if (!penSet) { Screen.SetFontColor(palette[color]); penSet = true; }
+                    int col = flip ? s.cols - open[i].col - open[i].len : open[i].col;
+                    Screen.FillRectangle(x + col * SPRITE_SCALE, y + open[i].row0 * SPRITE_SCALE,
+                                         open[i].len * SPRITE_SCALE, (row - open[i].row0) * SPRITE_SCALE);
+                }
+                for (int j = 0; j < numNext; ++j) open[j] = next[j];
+                numOpen = numNext;
+            }
+        }
+    }
+
+    /*
+        Function: drawPokemonGraphic
+        Inputs: const Pokemon &p, bool flip (if true, draw mirrored)
+        Returns: void
+        Purpose: Draws a simple composed graphic representing the Pokémon: outline box,
+                 RLE sprite in the species color, and a health bar.
+        Author: Aadit Bhatia
+    */
+    void drawPokemonGraphic(const Pokemon &p, bool flip=false)
+    {
+        // background box
+        Screen.SetFontColor(WHITE);
+        Screen.DrawRectangle(p.x - 6, p.y - 6, p.w + 12, p.h + 12);
+        // RLE sprite, tinted with the species color
+        drawSprite(p.sprite ? *p.sprite : MON_SPRITE, p.x, p.y, p.color, flip);
+
+        // add a little "health bar" on top of box as a filled rectangle 
+        int barW = p.w;
+        int hpperc = (p.hp * barW) / p.maxHP;
+        Screen.SetFontColor(RED);
+        Screen.FillRectangle(p.x, p.y - 10, barW, 6);
+        Screen.SetFontColor(GREEN);
+        Screen.FillRectangle(p.x, p.y - 10, hpperc, 6);
+    }
+
+    /*
+        Function: drawBackground
+        Inputs: none
+        Returns: void
+        Purpose: Draw a simple background composed of shapes (meets Basic+Advanced Graphics).
+                 Uses multiple rectangles and a ground band.
+        Author: Pranav Rajesh
+    */
+    void drawBackground()
+    {
+        if (bgLayer.empty()) buildBackgroundLayer();
+        Screen.Clear(bgLayer[0].color); // sky covers the whole screen, so a clear is the fastest way to lay it down
+        for (size_t i = 1; i < bgLayer.size(); ++i) {
+            const BgPrim &b = bgLayer[i];
+            Screen.SetFontColor(b.color);
+            if (b.filled) Screen.FillRectangle(b.x, b.y, b.w, b.h);
+            else Screen.DrawRectangle(b.x, b.y, b.w, b.h);
+        }
+    }
+
+    /*
+        Function: buildBackgroundLayer
+        Inputs: none
+        Returns: void
+        Purpose: Build the static background once as a list of primitives in paint order, so any part of
+                 it can be restored later without redrawing the whole screen.
+        Author: Pranav Rajesh
+    */
+    void buildBackgroundLayer()
+    {
+        bgLayer.clear();
+        bgLayer.push_back({0, 0, SCREEN_W, SCREEN_H, BLUE, true});  // sky
+        bgLayer.push_back({0, 160, SCREEN_W, 80, BROWN, true});     // ground band
+        bgLayer.push_back({260, 12, 34, 34, YELLOW, true});         // a simple sun
+        bgLayer.push_back({10, 10, 60, 30, WHITE, false});          // horizon line
+    }
+
+    /*
+        Function: restoreBackground
+        Inputs: int x, int y, int w, int h - region to restore
+        Returns: void
+        Purpose: Repaint only the part of the static background inside the region.
+                 Filled primitives are clipped to the region; outlines are redrawn whole if they touch it.
+    */
+    void restoreBackground(int x, int y, int w, int h)
+    {
+        if (bgLayer.empty()) buildBackgroundLayer();
+        for (auto &b : bgLayer) {
+            int x0 = max(x, b.x), y0 = max(y, b.y);
+            int x1 = min(x + w, b.x + b.w), y1 = min(y + h, b.y + b.h);
+            if (x0 >= x1 || y0 >= y1) continue;
+            Screen.SetFontColor(b.color);
+            if (b.filled) Screen.FillRectangle(x0, y0, x1 - x0, y1 - y0);
+            else Screen.DrawRectangle(b.x, b.y, b.w, b.h);
+        }
+    }
+
+    /*
+        Function: drawBattleStatus
+        Inputs: const Player &p1, const Player &p2
+        Returns: void
+        Purpose: Draws the HP and name text in the designated status area.
+        Author: Pranav Rajesh
+    */
+    void drawBattleStatus(const Player &p1, const Player &p2) {
+        Screen.SetFontColor(BLUE); // Clear the area where status text will go
+        Rect panel = statusPanelRect();
+        Screen.FillRectangle(panel.x, panel.y, panel.w, panel.h);
+       
+        Screen.SetFontColor(WHITE);
+        StatusLine lines[6];
+        int n = statusLines(p1, p2, lines);
+        for (int i = 0; i < n; ++i) Screen.WriteAt(lines[i].text.c_str(), lines[i].x, lines[i].y);
+        Screen.Update();
+    }
+
+    /*
+        Function: statusLines
+        Inputs: const Player &p1, const Player &p2, StatusLine out[6]
+        Returns: int number of lines filled in
+        Purpose: The text shown in the status panel (names, HP, defend markers) and where it goes.
+        Author: Pranav Rajesh
+    */
+    int statusLines(const Player &p1, const Player &p2, StatusLine out[6])
+    {
+        int n = 0;
+        // Player 1 Status (Left)
+        out[n++] = {p1.pkmn.name + " (P1)", 8, STATUS_TEXT_Y};
+        out[n++] = {"HP: " + to_string(p1.pkmn.hp) + "/" + to_string(p1.pkmn.maxHP), 8, STATUS_TEXT_Y + 14};
+        // Player 2 Status (Right)
+        out[n++] = {p2.pkmn.name + " (P2)", 170, STATUS_TEXT_Y};
+        out[n++] = {"HP: " + to_string(p2.pkmn.hp) + "/" + to_string(p2.pkmn.maxHP), 170, STATUS_TEXT_Y + 14};
+
+        if (p1.pkmn.defending) out[n++] = {"[Defending]", 8, STATUS_TEXT_Y + 28};
+        if (p2.pkmn.defending) out[n++] = {"[Defending]", 170, STATUS_TEXT_Y + 28};
+        return n;
+    }
+
+    // screen areas of the compositor's items
+    Rect statusPanelRect() const { return {0, STATUS_TEXT_Y - 5, SCREEN_W, BBTN_START_Y - STATUS_TEXT_Y + 5}; }
+    Rect graphicRect(const Pokemon &p) const { return {p.x - 6, p.y - 10, p.w + 13, p.h + 17}; } // outline box + health bar
+    Rect buttonRect(int i) const { return {btns[i].x, btns[i].y, btns[i].w + 1, btns[i].h + 1}; }
+    Rect textRect(const string &text, int x, int y) const { return {x, y, (int)text.size() * 12, 17}; }
+
+    /*
+        Function: drawBattleButton
+        Inputs: int i - button index
+        Returns: void
+        Purpose: Draw one battle button, highlighted if it is the chosen one.
+        Author: Aadit Bhatia
+    */
+    void drawBattleButton(int i)
+    {
+        const BattleButton &b = btns[i];
+        if (i == highlightBtn) {
+            Screen.SetFontColor(BLACK); Screen.FillRectangle(b.x, b.y, b.w, b.h);
+            Screen.SetFontColor(YELLOW); Screen.WriteAt(b.label.c_str(), b.x + 6, b.y + 12);
+        } else {
+            Screen.SetFontColor(WHITE);
+            Screen.DrawRectangle(b.x, b.y, b.w, b.h);
+            Screen.WriteAt(b.label.c_str(), b.x + 6, b.y + 12);
+        }
+    }
+
+    /*
+        Function: markDirty
+        Inputs: const Rect &r
+        Returns: void
+        Purpose: Record that the battle screen changed inside r; it is repainted by the next composite().
+    */
+    void markDirty(const Rect &r)
+    {
+        Rect m = r;
+        // merge with any overlapping dirty rect so shared pixels are only painted once
+        for (size_t i = 0; i < dirty.size(); ) {
+            if (dirty[i].intersects(m)) { m.unite(dirty[i]); dirty.erase(dirty.begin() + i); }
+            else ++i;
+        }
+        dirty.push_back(m);
+    }
+
+    /*
+        Function: composite
+        Inputs: none
+        Returns: void
+        Purpose: Repaint every dirty rectangle from the layers, bottom to top. Painting starts at the
+                 highest layer that fully covers the rectangle with something opaque (the status panel or
+                 a highlighted button), so hidden layers are skipped. Items that can only be drawn whole
+                 (text, Pokémon graphics) grow the area that later layers must repaint over.
+                 Does not call Screen.Update().
+    */
+    void composite()
+    {
+        for (auto &r : dirty) {
+            Rect area = r;
+            int start = LAYER_BACKGROUND;
+            if (statusPanelRect().contains(r)) start = LAYER_STATUS;
+            if (highlightBtn >= 0 && buttonRect(highlightBtn).contains(r)) start = LAYER_BUTTONS;
+
+            if (start <= LAYER_BACKGROUND) restoreBackground(r.x, r.y, r.w, r.h);
+
+            if (start <= LAYER_STATUS) {
+                Rect panel = statusPanelRect();
+                if (panel.intersects(r)) {
+                    int x0 = max(r.x, panel.x), y0 = max(r.y, panel.y);
+                    int x1 = min(r.x + r.w, panel.x + panel.w), y1 = min(r.y + r.h, panel.y + panel.h);
+                    Screen.SetFontColor(BLUE);
+                    Screen.FillRectangle(x0, y0, x1 - x0, y1 - y0);
+                    Screen.SetFontColor(WHITE);
+                    StatusLine lines[6];
+                    int n = statusLines(p1, p2, lines);
+                    for (int i = 0; i < n; ++i) {
+                        Rect t = textRect(lines[i].text, lines[i].x, lines[i].y);
+                        if (!t.intersects(r)) continue;
+                        Screen.WriteAt(lines[i].text.c_str(), lines[i].x, lines[i].y);
+                        area.unite(t);
+                    }
+                }
+            }
+
+            if (start <= LAYER_SPRITES) {
+                const Pokemon *mons[2] = { &p1.pkmn, &p2.pkmn };
+                for (int i = 0; i < 2; ++i) {
+                    Rect g = graphicRect(*mons[i]);
+                    if (!g.intersects(area)) continue;
+                    drawPokemonGraphic(*mons[i], i == 1);
+                    area.unite(g);
+                }
+            }
+
+            if (start <= LAYER_EFFECTS && fxActive && fxRect.intersects(area)) {
+                Screen.SetFontColor(YELLOW);
+                Screen.FillRectangle(fxRect.x, fxRect.y, fxRect.w, fxRect.h);
+            }
+
+            for (int i = 0; i < NUM_BATTLE_BTNS; ++i) {
+                if (buttonRect(i).intersects(area)) drawBattleButton(i);
+            }
+        }
+        dirty.clear();
+    }
+
+
+    /*
+        Function: cpuChooseAction
+        Inputs: const Pokemon &actor
+        Returns: int button index (0..2 = move, 3 = run)
+        Purpose: CPU decision based on difficulty. Easy is mostly random; Hard prefers the strongest move.
+        Author: Aadit Bhatia
+    */
+    int cpuChooseAction(const Pokemon &actor)
+    {
+        PhaseScope phase(PHASE_CPU);
+        long long startMs = NowMs();
+        int chosen;
+        int r = randInt(1,100);
+        if (difficulty == 0) { // Easy: more random
+            if (r <= 35) chosen = 0;
+            else if (r <= 70) chosen = 1;
+            else if (r <= 85) chosen = 2; // move 3 (utility)
+            else chosen = 3; // run occasionally
+        } else { // Hard: prefer strongest move and attacks
+            int best = 0;
+            for (int i=0;i<(int)actor.moves.size();++i) if (actor.moves[i].power > actor.moves[best].power && actor.moves[i].pp>0) best=i;
+            chosen = (randInt(1,100) <= 85) ? best : 3;
+        }
+        long long thinkMs = NowMs() - startMs;
+        if (thinkMs > WATCHDOG_CPU_BUDGET_MS) watchdogOverrun(thinkMs, WATCHDOG_CPU_BUDGET_MS);
+        return chosen;
+    }
+
+    /*
+        Function: animateProjectile
+        Inputs: const Pokemon &actor, const Pokemon &target, int dir (1 = left to right, -1 = right to left)
+        Returns: bool (true if the projectile reached the target)
+        Purpose: Animate the projectile from actor to target and detect collision with its bounding box.
+        Author: Aadit Bhatia
+    */
+    bool animateProjectile(const Pokemon &actor, const Pokemon &target, int dir)
+    {
+        PhaseScope phase(PHASE_PROJECTILE);
+        // projectile represented as small filled rectangle that moves across
+        int projX = actor.x + (dir > 0 ? actor.w : -8);
+        int projY = actor.y + actor.h/2;
+        bool hit = false;
+
+        // Only the effects layer changes: mark the old and new projectile areas dirty
+        // and let the compositor repaint just those.
+        while (projX > 0 && projX < SCREEN_W) {
+            if (fxActive) markDirty(fxRect);
+            fxRect = {projX, projY - 4, 8, 8};
+            fxActive = true;
+            markDirty(fxRect);
+            composite();
+            Screen.Update();
+
+
+            // check collision with target bounding box
+            int tx1 = target.x, ty1 = target.y, tw = target.w, th = target.h;
+            int px1 = projX, py1 = projY - 4, pw = 8, ph = 8;
+            bool overlap = !(px1 + pw < tx1 || px1 > tx1 + tw || py1 + ph < ty1 || py1 > ty1 + th);
+            if (overlap) { hit = true; break; }
+
+
+            // step projectile
+            projX += dir * PROJECTILE_STEP_PX;
+            SleepMs(PROJECTILE_SPEED_MS);
+        } // end projectile animate
+        fxActive = false;
+        return hit;
+    }
+
+    /*
+        Function: projectileReaches
+        Inputs: const Pokemon &actor, const Pokemon &target, int dir
+        Returns: bool (true if the projectile reached the target)
+        Purpose: animateProjectile, unless the fuzzer has stubbed the outcome (see fuzzProjectile).
+    */
+    bool projectileReaches(const Pokemon &actor, const Pokemon &target, int dir)
+    {
+#ifdef MINIMON_FUZZ
+        if (fuzzProjectile >= 0) return fuzzProjectile != 0;
+#endif
+        return animateProjectile(actor, target, dir);
+    }
+
+    /*
+        Function: resolveAction
+        Inputs: Pokemon &actor, Pokemon &target, int chosen (button index, -1 = nothing),
+                bool animate (show the projectile; false for headless use), int dir (projectile direction)
+        Returns: ActionResult - what happened and the damage dealt
+        Purpose: The battle rules for one action: retreat, defend (utility moves), accuracy roll, damage,
+                 defend halving and PP. runMatch shows the result; headless callers just use the state.
+        Author: Aadit Bhatia and Pranav Rajesh
+    */
+    ActionResult resolveAction(Pokemon &actor, Pokemon &target, int chosen, bool animate, int dir)
+    {
+        ActionResult res = {ACT_NONE, 0};
+        if (chosen == 3) { // Run
+            // retreat: heal a bit and end match (counts as immediate exit)
+            actor.hp += RETREAT_HEAL;
+            if (actor.hp > actor.maxHP) actor.hp = actor.maxHP;
+            res.outcome = ACT_RETREAT;
+            return res;
+        }
+        if (chosen == -1) return res;
+
+        // Attack using move index = chosen (0..2)
+        int mIdx = chosen;
+        if (mIdx >= (int)actor.moves.size()) mIdx = 0;
+        Move &mv = actor.moves[mIdx];
+
+        if (mv.pp <= 0) {
+            res.outcome = ACT_NO_PP;
+        } else if (mv.power == 0) {
+            // If move power is 0, treat as utility/defend
+            // Assume utility move is defend/boost for simplicity
+            actor.defending = true;
+            mv.pp--;
+            res.outcome = ACT_DEFEND;
+        } else { // Standard attack move (power > 0)
+            int roll = randInt(1,100);
+            flightRecord(FR_ROLL, 0, roll, mv.accuracy);
+            if (roll > mv.accuracy) {
+                res.outcome = ACT_MISS;
+            } else if (animate && !projectileReaches(actor, target, dir)) {
+                mv.pp--;
+                res.outcome = ACT_NO_HIT;
+            } else {
+                // apply damage formula
+                PhaseScope phase(PHASE_DAMAGE);
+                int dmg = computeDamage(actor, target, mv);
+                bool halved = target.defending;
+                if (target.defending) {
+                    dmg = (dmg + 1)/2;
+                    target.defending = false;
+                }
+                target.hp -= dmg; if (target.hp < 0) target.hp = 0;
+                flightRecord(FR_DAMAGE, dmg, target.hp, halved);
+                mv.pp--;
+                res.outcome = ACT_HIT;
+                res.damage = dmg;
+            }
+        }
+
+        // If the actor attacked, clear their defend state for next turn. Target state is cleared on hit.
+        if (actor.defending && mv.power > 0) actor.defending = false;
+        return res;
+    }
+
+    /*
+        Function: runMatch
+        Inputs: none
+        Returns: bool (true = player chose to replay immediately)
+        Purpose: Runs one full match (turn loop) including animated projectile attacks,
+                 uses button UI, handles collisions, and returns whether to automatically replay.
+        Author: Aadit Bhatia
+        Resources: Learned the use of vectors from W3Schools
+    */
+    
+    bool runMatch()
+    {
+        PhaseScope phase(PHASE_BATTLE);
+        // Tracking: current turn (true -> p1)
+        bool p1Turn = true;
+
+
+        // Reset defend states
+        p1.pkmn.defending = false; p2.pkmn.defending = false;
+        flightRecord(FR_MATCH, 0, p1.pkmn.hp, p2.pkmn.hp);
+#ifdef MINIMON_BROADCAST
+        {
+            const string names[2] = { p1.pkmn.name, p2.pkmn.name };
+            const int hp[2] = { p1.pkmn.hp, p2.pkmn.hp };
+            vector<int> pp[2];
+            for (auto &m : p1.pkmn.moves) pp[0].push_back(m.pp);
+            for (auto &m : p2.pkmn.moves) pp[1].push_back(m.pp);
+            broadcast.matchStart(names, hp, pp, p1.isHuman, difficulty, rngState);
+        }
+#endif
+
+
+        // Battle loop(while both alive)
+        while (!p1.pkmn.fainted() && !p2.pkmn.fainted())
+        {
+            // draw scene: background, status, then pokemon so pokemon render on top of status area
+            drawBackground();
+            drawBattleStatus(p1, p2);
+            drawPokemonGraphic(p1.pkmn, false);
+            drawPokemonGraphic(p2.pkmn, true);
+
+
+            // draw 4 battle buttons (2x2 grid)
+            Player *actor = p1Turn ? &p1 : &p2;
+            Player *target = p1Turn ? &p2 : &p1;
+
+
+            // Build button rectangles and labels
+           
+            // Helper lambda to calculate Y position for row (0 or 1)
+            auto getY = [](int row) { return BBTN_START_Y + row * (BBTN_H + BBTN_GAP); };
+
+
+            // Button 0 (Top Left) - Move 1
+            btns[0] = {BBTN_LEFT_X, getY(0), BBTN_W, BBTN_H, actor->pkmn.moves[0].name + " (" + to_string(actor->pkmn.moves[0].pp) + ")", 0};
+           
+            // Button 1 (Top Right) - Move 2
+            btns[1] = {BBTN_RIGHT_X, getY(0), BBTN_W, BBTN_H, actor->pkmn.moves[1].name + " (" + to_string(actor->pkmn.moves[1].pp) + ")", 1};
+           
+            // Button 2 (Bottom Left) - Move 3
+            btns[2] = {BBTN_LEFT_X, getY(1), BBTN_W, BBTN_H, actor->pkmn.moves[2].name + " (" + to_string(actor->pkmn.moves[2].pp) + ")", 2};
+
+
+            // Button 3 (Bottom Right) - Run
+            btns[3] = {BBTN_RIGHT_X, getY(1), BBTN_W, BBTN_H, "RUN", 3};
+
+
+
+
+            // Draw buttons
+            highlightBtn = -1;
+            fxActive = false;
+            for (int i = 0; i < NUM_BATTLE_BTNS; ++i) drawBattleButton(i);
+            Screen.Update();
+
+
+            // If actor is human, wait for button press; for CPU, decide action and animate small pause
+            int chosen = -1;
+            if (actor->isHuman) {
+                // wait for clean press and map to button hitboxes
+                int tx, ty;
+                WaitForCleanPress(tx, ty);
+
+
+                // find which button was pressed
+                //same loop logic as drawing buttons, but now checking if touch coords are within button bounds
+                bool found = false;
+                for (auto &b : btns) {
+                    if (tx >= b.x && tx <= b.x + b.w && ty >= b.y && ty <= b.y + b.h) {
+                        chosen = b.id;
+                        // highlight visual
+                        highlightBtn = chosen;
+                        markDirty(buttonRect(chosen));
+                        composite();
+                        Screen.Update();
+                        SleepMs(160);
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found) {
+                    // Nothing valid pressed; skip to next iteration
+                    continue;
+                }
+            } else {
+                // CPU decision based on difficulty
+                SleepMs(400);
+                chosen = cpuChooseAction(actor->pkmn);
+                // Highlight CPU chosen button
+                if (chosen != -1) {
+                    highlightBtn = chosen;
+                    markDirty(buttonRect(chosen));
+                    composite();
+                    Screen.Update();
+                    SleepMs(300);
+                }
+            }
+
+
+            // Process chosen action (rules in resolveAction, which also runs the projectile animation)
+            flightRecord(FR_ACTION, actor == &p1 ? 1 : 2, chosen, actor->pkmn.hp);
+            ActionResult res = resolveAction(actor->pkmn, target->pkmn, chosen, true, actor == &p1 ? 1 : -1);
+#ifdef MINIMON_BROADCAST
+            broadcast.action(actor == &p1 ? 0 : 1, chosen, !actor->isHuman, res.outcome, res.damage);
+#endif
+            int mIdx = (chosen >= 0 && chosen < (int)actor->pkmn.moves.size()) ? chosen : 0;
+            const string &mvName = actor->pkmn.moves[mIdx].name;
+            switch (res.outcome) {
+                case ACT_RETREAT:
+                    Screen.Clear(BLACK); Screen.WriteLine((actor->pkmn.name + " retreated and healed.").c_str());
+                    flightRecord(FR_MATCH, 1, p1.pkmn.hp, p2.pkmn.hp);
+                    saveCheckpoint(); // a retreat ends the match too, so it must reach the checkpoint
+                    SleepMs(800);
+                    // treat retreat as match over and go to menu (no play again)
+                    return false;
+                case ACT_NO_PP:
+                    Screen.Clear(BLACK); Screen.WriteLine("No PP left for that move."); SleepMs(700);
+                    break;
+                case ACT_DEFEND:
+                    Screen.Clear(BLACK); Screen.WriteLine((actor->pkmn.name + " used " + mvName + "! Defending...").c_str());
+                    SleepMs(900);
+                    break;
+                case ACT_MISS:
+                    Screen.Clear(BLACK);
+                    Screen.WriteLine((actor->pkmn.name + " used " + mvName + " but missed!").c_str());
+                    SleepMs(900);
+                    break;
+                case ACT_HIT:
+                    Screen.Clear(BLACK);
+                    Screen.WriteLine((actor->pkmn.name + " used " + mvName + "!").c_str());
+                    Screen.WriteLine(("Hit for " + to_string(res.damage) + " dmg").c_str());
+                    SleepMs(900);
+                    break;
+                case ACT_NO_HIT:
+                    // projectile flew off screen - treat as miss (shouldn't happen with animation logic)
+                    Screen.Clear(BLACK);
+                    Screen.WriteLine((actor->pkmn.name + " used " + mvName + " - no hit.").c_str());
+                    SleepMs(700);
+                    break;
+                case ACT_NONE:
+                    break;
+            }
+           
+            // small pause, then swap turns
+            SleepMs(200);
+            p1Turn = !p1Turn;
+        } // end while battle
+
+
+        // End of battle - display result
+        PhaseScope resultPhase(PHASE_RESULT);
+        flightRecord(FR_MATCH, 1, p1.pkmn.hp, p2.pkmn.hp);
+        Screen.Clear(BLACK);
+        if (p1.pkmn.fainted() && p2.pkmn.fainted()) {
+            Screen.WriteLine("It's a tie!");
+        } else if (p1.pkmn.fainted()) {
+            Screen.WriteLine((p1.label + " lost. " + p2.label + " wins!").c_str());
+            if (p2.isHuman) humanWins++; else cpuWins++;
+        } else if (p2.pkmn.fainted()) {
+            Screen.WriteLine((p2.label + " lost. " + p1.label + " wins!").c_str());
+            if (p1.isHuman) humanWins++; else cpuWins++;
+        } else {
+            Screen.WriteLine("Match ended unexpectedly.");
+        }
+        gamesPlayed++;
+        // checkpoint while the result is on screen so it never delays a turn
+        saveCheckpoint();
+        SleepMs(RESULT_PAUSE_MS);
+
+
+        // Ask for replay
+        Screen.WriteLine("");
+        Screen.WriteLine("Play again? Tap TOP half = YES, bottom half = NO");
+        int rx, ry;
+        WaitForCleanPress(rx, ry);
+        bool again = (ry < SCREEN_H/2);
+        SleepMs(400);
+        return again;
+    } // end runMatch
+
+    /*
+        Function: saveCheckpoint
+        Inputs: none
+        Returns: void
+        Purpose: Write a compact checkpoint of the session (stats, difficulty and RNG stream position)
+                 so that a power cycle or reset does not lose it.
+    */
+    void saveCheckpoint()
+    {
+        FEHFile *f = SD.FOpen(CHECKPOINT_FILE, "w");
+        if (f == nullptr) return; // no storage: keep playing without checkpoints
+        SD.FPrintf(f, "%d %d %d %d %d %u %u %u %u\n", CHECKPOINT_VERSION, gamesPlayed, humanWins, cpuWins,
+                   difficulty, (unsigned)rngState[0], (unsigned)rngState[1], (unsigned)rngState[2], (unsigned)rngState[3]);
+        SD.FClose(f);
+    }
+
+    /*
+        Function: loadCheckpoint
+        Inputs: none
+        Returns: bool (true if a valid checkpoint was restored)
+        Purpose: Restore a checkpoint written by saveCheckpoint, including the RNG stream position,
+                 so the resumed session continues exactly where the interrupted one stopped.
+    */
+    bool loadCheckpoint()
+    {
+        FEHFile *f = SD.FOpen(CHECKPOINT_FILE, "r");
+        if (f == nullptr) return false;
+        int version = 0, played = 0, hWins = 0, cWins = 0, diff = 0;
+        unsigned int st[4] = { 0, 0, 0, 0 };
+        int read = SD.FScanf(f, "%d %d %d %d %d %u %u %u %u", &version, &played, &hWins, &cWins, &diff,
+                             &st[0], &st[1], &st[2], &st[3]);
+        SD.FClose(f);
+        if (read != 9 || version != CHECKPOINT_VERSION) return false;
+        if ((st[0] | st[1] | st[2] | st[3]) == 0) return false;
+
+        gamesPlayed = played; humanWins = hWins; cpuWins = cWins;
+        difficulty = (diff == 1) ? 1 : 0;
+        for (int i = 0; i < 4; ++i) rngState[i] = st[i];
+        return true;
+    }
+
+
+}; // end class Game
+
+#ifdef MINIMON_VIEWER
+// ----------------------------- SPECTATOR VIEWER -----------------------------
+// Connects to a MINIMON_BROADCAST host. MINIMON_VIEW=actions asks for the action stream and re-simulates
+// each match locally (same rules, same RNG state), reporting any turn whose outcome differs from the
+// host's; otherwise the viewer asks for frames and replays the host's draw calls on its own screen.
+
+/*
+    Function: readFull
+    Inputs: int fd, uint8_t *buf, size_t n
+    Returns: bool (false once the host has gone away)
+    Purpose: Blocking read of exactly n bytes from the broadcast socket.
+*/
+bool readFull(int fd, uint8_t *buf, size_t n)
+{
+    while (n > 0) {
+        ssize_t r = read(fd, buf, n);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        buf += r; n -= (size_t)r;
+    }
+    return true;
+}
+
+/*
+    Function: viewerDrawFrame
+    Inputs: const vector<uint8_t> &ops
+    Returns: bool (false if the frame is malformed; the ops before the bad one are still drawn)
+    Purpose: Replay one frame of broadcast draw ops through Screen, then show it.
+*/
+bool viewerDrawFrame(const vector<uint8_t> &ops)
+{
+    size_t i = 0;
+    string text;
+    auto has = [&](size_t n) { return ops.size() - i >= n; };
+    bool ok = true;
+    while (ok && i < ops.size()) {
+        int op = ops[i++];
+        if (op == OP_CLEAR || op == OP_COLOR) {
+            if (!has(4)) { ok = false; break; }
+            unsigned int color = getU32(&ops[i]); i += 4;
+            if (op == OP_CLEAR) Screen.Clear(color); else Screen.SetFontColor(color);
+        } else if (op == OP_FILL || op == OP_RECT) {
+            if (!has(8)) { ok = false; break; }
+            int x = getU16(&ops[i]), y = getU16(&ops[i + 2]), w = getU16(&ops[i + 4]), h = getU16(&ops[i + 6]);
+            i += 8;
+            if (op == OP_FILL) Screen.FillRectangle(x, y, w, h); else Screen.DrawRectangle(x, y, w, h);
+        } else if (op == OP_TEXT_AT || op == OP_LINE) {
+            int x = 0, y = 0;
+            if (!has(op == OP_TEXT_AT ? 6 : 2)) { ok = false; break; }
+            if (op == OP_TEXT_AT) { x = getU16(&ops[i]); y = getU16(&ops[i + 2]); i += 4; }
+            size_t len = (uint16_t)getU16(&ops[i]); i += 2;
+            if (!has(len)) { ok = false; break; }
+            text.assign((const char*)&ops[i], len); i += len;
+            if (op == OP_TEXT_AT) Screen.WriteAt(text.c_str(), x, y); else Screen.WriteLine(text.c_str());
+        } else {
+            ok = false; // unknown op: the rest of this frame cannot be decoded
+        }
+    }
+    Screen.Update();
+    return ok;
+}
+
+/*
+    Function: runViewer
+    Inputs: Game &game (bank loaded; used to re-simulate the action stream)
+    Returns: int process exit code (1 if the host could not be reached, sent malformed messages or the
+             re-simulation desynced)
+    Purpose: Spectator client: connect, pick a stream, and follow the host until it exits.
+*/
+int runViewer(Game &game)
+{
+    const char *view = getenv("MINIMON_VIEW");
+    char mode = (view && strcmp(view, "actions") == 0) ? 'A' : 'F';
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, BROADCAST_SOCKET, sizeof(addr.sun_path) - 1);
+    if (fd < 0 || connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || write(fd, &mode, 1) != 1) {
+        perror("viewer connect");
+        return 1;
+    }
+
+    static const char* OUTCOME_NAMES[] = { "nothing", "retreat", "no PP", "defend", "miss", "hit", "no hit" };
+    long frames = 0, matches = 0, actions = 0, desyncs = 0, malformed = 0;
+    long long bytes = 0;
+    Pokemon mons[2];
+    bool inMatch = false;
+    uint8_t header[BROADCAST_HEADER_BYTES];
+    vector<uint8_t> msg;
+    while (readFull(fd, header, sizeof(header))) {
+        uint32_t length = getU32(header);
+        if (length > BROADCAST_MAX_MESSAGE) {
+            // the framing itself cannot be trusted any more
+            printf("viewer: %u-byte message exceeds the %zu-byte limit, disconnecting\n", (unsigned)length, BROADCAST_MAX_MESSAGE);
+            malformed++;
+            break;
+        }
+        msg.resize(length);
+        if (!readFull(fd, msg.data(), msg.size())) break;
+        bytes += (long long)(sizeof(header) + msg.size());
+        int kind = header[4];
+
+        if (kind == MSG_FRAME) {
+            frames++;
+            if (!viewerDrawFrame(msg)) { printf("viewer: malformed frame %ld\n", frames); malformed++; }
+        } else if (kind == MSG_MATCH_START) {
+            // every field is bounds-checked: a short or inconsistent message skips the match
+            size_t i = 0;
+            auto has = [&](size_t n) { return msg.size() - i >= n; };
+            bool valid = true;
+            inMatch = true;
+            for (int s = 0; s < 2 && valid && inMatch; ++s) {
+                if (!has(1) || !has(1 + (size_t)msg[i] + 3)) { valid = false; break; }
+                string name((const char*)&msg[i + 1], msg[i]); i += 1 + msg[i];
+                inMatch = false;
+                for (auto &b : game.bank) if (b.name == name) { mons[s] = b; inMatch = true; }
+                if (!inMatch) { printf("viewer: unknown species %s, skipping match\n", name.c_str()); break; }
+                mons[s].hp = getU16(&msg[i]); i += 2;
+                int n = msg[i++];
+                if (!has(2 * (size_t)n)) { valid = false; break; }
+                for (int m = 0; m < n; ++m, i += 2) if (m < (int)mons[s].moves.size()) mons[s].moves[m].pp = getU16(&msg[i]);
+                mons[s].defending = false;
+            }
+            if (valid && !has(2 + 16)) valid = false;
+            if (!valid) { printf("viewer: malformed match start (%zu bytes), skipping match\n", msg.size()); malformed++; inMatch = false; }
+            if (!inMatch) continue;
+            bool p1Human = msg[i] != 0;
+            game.difficulty = msg[i + 1];
+            for (int r = 0; r < 4; ++r) rngState[r] = getU32(&msg[i + 2 + 4 * r]);
+            matches++;
+            printf("match %ld: %s (%s) vs %s (%s), %s\n", matches, mons[0].name.c_str(), p1Human ? "human" : "CPU",
+                   mons[1].name.c_str(), p1Human ? "CPU" : "human", game.difficulty ? "hard" : "easy");
+        } else if (kind == MSG_ACTION && inMatch) {
+            if (msg.size() != (size_t)BROADCAST_ACTION_BYTES || msg[0] >= 2 || msg[3] > Game::ACT_NO_HIT) {
+                printf("viewer: malformed action (%zu bytes), abandoning match\n", msg.size());
+                malformed++;
+                inMatch = false;
+                continue;
+            }
+            int side = msg[0], chosen = (int8_t)msg[1], outcome = msg[3], damage = getU16(&msg[4]);
+            bool byCpu = msg[2] != 0;
+            actions++;
+            Pokemon &actor = mons[side];
+            Pokemon &target = mons[1 - side];
+            // the CPU's choice draws from the RNG, so replay it to stay in step (and check it)
+            if (byCpu && game.cpuChooseAction(actor) != chosen) desyncs++;
+            Game::ActionResult res;
+            if (outcome == Game::ACT_NO_HIT && chosen >= 0 && chosen < (int)actor.moves.size()) {
+                // the host's projectile never reached the target; nothing here decides that, so mirror it
+                randInt(1, 100);
+                actor.moves[chosen].pp--;
+                actor.defending = false;
+                res = {Game::ACT_NO_HIT, 0};
+            } else {
+                res = game.resolveAction(actor, target, chosen, false, 1);
+            }
+            bool ok = res.outcome == outcome && res.damage == damage;
+            if (!ok) desyncs++;
+            int mIdx = (chosen >= 0 && chosen < (int)actor.moves.size()) ? chosen : 0;
+            printf("  %s %s: %s", actor.name.c_str(), chosen == 3 ? "RUN" : actor.moves[mIdx].name.c_str(),
+                   OUTCOME_NAMES[res.outcome]);
+            if (res.outcome == Game::ACT_HIT) printf(" %d (%s %d HP)", res.damage, target.name.c_str(), target.hp);
+            if (!ok) printf("  DESYNC: host said %s %d", outcome < 7 ? OUTCOME_NAMES[outcome] : "?", damage);
+            printf("\n");
+            if (res.outcome == Game::ACT_RETREAT || actor.fainted() || target.fainted()) inMatch = false;
+        }
+    }
+    ::close(fd);
+    if (mode == 'F') printf("viewer: %ld frames, %lld bytes\n", frames, bytes);
+    else printf("viewer: %ld matches, %ld actions, %ld desyncs\n", matches, actions, desyncs);
+    if (malformed) printf("viewer: %ld malformed messages\n", malformed);
+    return desyncs || malformed ? 1 : 0;
+}
+#endif
+
+// ----------------------------- HEADLESS BATTLE ENGINE -----------------------------
+const int MAX_MOVES = 3;
+const int NUM_DAMAGE_ROLLS = DAMAGE_ROLL_MAX - DAMAGE_ROLL_MIN + 1;
+const int RANDOM_BLOCK = 64;
+
+/*
+    Class: RandomBlock
+    Members:
+      - uint32_t s[4] : xoshiro128** words, kept apart from the global rngState
+      - uint32_t buf[RANDOM_BLOCK], next : values generated ahead, and the next one to hand out
+    Methods:
+      - seed(seed) : same expansion as seedRandom, so seed(x) gives exactly the stream seedRandom(x) would
+      - range(a, b) : same unbiased reduction as randInt
+    Purpose: Bulk random numbers for the headless engine. refill() runs the generator RANDOM_BLOCK
+             steps at a time with its words in registers, instead of loading and storing the global
+             state on every draw. The stream is the same one randInt produces, which keeps the
+             differential fuzzer comparing like with like.
+*/
+struct RandomBlock {
+    uint32_t s[4];
+    uint32_t buf[RANDOM_BLOCK];
+    int next;
+
+    void seed(uint32_t seed)
+    {
+        for (int i = 0; i < 4; ++i) {
+            seed += 0x9E3779B9u;
+            uint32_t z = seed;
+            z = (z ^ (z >> 16)) * 0x85EBCA6Bu;
+            z = (z ^ (z >> 13)) * 0xC2B2AE35u;
+            s[i] = z ^ (z >> 16);
+        }
+        if ((s[0] | s[1] | s[2] | s[3]) == 0) s[0] = 1;
+        next = RANDOM_BLOCK;
+    }
+
+    void refill()
+    {
+        uint32_t s0 = s[0], s1 = s[1], s2 = s[2], s3 = s[3];
+        for (int i = 0; i < RANDOM_BLOCK; ++i) {
+            uint32_t x = s1 * 5;
+            buf[i] = ((x << 7) | (x >> 25)) * 9;
+            uint32_t t = s1 << 9;
+            s2 ^= s0; s3 ^= s1; s1 ^= s2; s0 ^= s3;
+            s2 ^= t;
+            s3 = (s3 << 11) | (s3 >> 21);
+        }
+        s[0] = s0; s[1] = s1; s[2] = s2; s[3] = s3;
+        next = 0;
+    }
+
+    uint32_t raw()
+    {
+        if (next == RANDOM_BLOCK) refill();
+        return buf[next++];
+    }
+
+    int range(int a, int b)
+    {
+        uint32_t span = (uint32_t)(b - a + 1);
+        uint64_t m = (uint64_t)raw() * span;
+        if ((uint32_t)m < span) {
+            uint32_t threshold = (0u - span) % span;
+            while ((uint32_t)m < threshold) m = (uint64_t)raw() * span;
+        }
+        return a + (int)(m >> 32);
+    }
+};
+
+/*
+    Class: FastBattle
+    Members:
+      - int hp[2], maxHP[2], numMoves[2] : side 0 = first mover (p1), side 1 = p2
+      - int power, accuracy, pp [side][move]
+      - bool defending[2]
+      - uint16_t damage[side][move][roll] : damage that side deals to the other side, per damage roll
+      - RandomBlock rng : the battle's random stream (seed it before playing)
+    Methods:
+      - init(game, a, b) : copy two Pokémon and precompute the damage tables for the game's difficulty
+      - cpuChoose(side) : same decision as Game::cpuChooseAction
+      - act(side, chosen, reaches) : same rules as Game::resolveAction; `reaches` stands in for the
+                                     animated projectile (false gives ACT_NO_HIT)
+    Purpose: Headless engine for bulk simulation. Flat integer state and table lookups instead of
+             strings, vectors and floating point per hit. It draws random numbers in exactly the same
+             order as the reference rules, so rng.seed(x) gives the same match as seedRandom(x).
+*/
+struct FastBattle {
+    int hp[2], maxHP[2], numMoves[2];
+    int power[2][MAX_MOVES], accuracy[2][MAX_MOVES], pp[2][MAX_MOVES];
+    bool defending[2];
+    int difficulty;
+    uint16_t damage[2][MAX_MOVES][NUM_DAMAGE_ROLLS];
+    RandomBlock rng;
+
+    void init(Game &game, const Pokemon &a, const Pokemon &b)
+    {
+        const Pokemon *mons[2] = { &a, &b };
+        difficulty = game.difficulty;
+        for (int s = 0; s < 2; ++s) {
+            const Pokemon &p = *mons[s];
+            hp[s] = p.hp; maxHP[s] = p.maxHP; defending[s] = p.defending;
+            numMoves[s] = min((int)p.moves.size(), MAX_MOVES);
+            for (int m = 0; m < numMoves[s]; ++m) {
+                power[s][m] = p.moves[m].power;
+                accuracy[s][m] = p.moves[m].accuracy;
+                pp[s][m] = p.moves[m].pp;
+                for (int r = 0; r < NUM_DAMAGE_ROLLS; ++r)
+                    damage[s][m][r] = (uint16_t)game.damageForRoll(p, *mons[1 - s], p.moves[m], DAMAGE_ROLL_MIN + r);
+            }
+        }
+    }
+
+    int cpuChoose(int side)
+    {
+        int r = rng.range(1,100);
+        if (difficulty == 0) return r <= 35 ? 0 : r <= 70 ? 1 : r <= 85 ? 2 : 3;
+        int best = 0;
+        for (int i = 0; i < numMoves[side]; ++i) if (power[side][i] > power[side][best] && pp[side][i] > 0) best = i;
+        return (rng.range(1,100) <= 85) ? best : 3;
+    }
+
+    Game::ActionResult act(int side, int chosen, bool reaches = true)
+    {
+        Game::ActionResult res = {Game::ACT_NONE, 0};
+        if (chosen == 3) {
+            hp[side] = min(hp[side] + RETREAT_HEAL, maxHP[side]);
+            res.outcome = Game::ACT_RETREAT;
+            return res;
+        }
+        if (chosen == -1) return res;
+
+        int m = chosen < numMoves[side] ? chosen : 0;
+        int other = 1 - side;
+        if (pp[side][m] <= 0) {
+            res.outcome = Game::ACT_NO_PP;
+        } else if (power[side][m] == 0) {
+            defending[side] = true;
+            pp[side][m]--;
+            res.outcome = Game::ACT_DEFEND;
+        } else if (rng.range(1,100) > accuracy[side][m]) {
+            res.outcome = Game::ACT_MISS;
+        } else if (!reaches) {
+            pp[side][m]--;
+            res.outcome = Game::ACT_NO_HIT;
+        } else {
+            int dmg = damage[side][m][rng.range(DAMAGE_ROLL_MIN, DAMAGE_ROLL_MAX) - DAMAGE_ROLL_MIN];
+            if (defending[other]) { dmg = (dmg + 1) / 2; defending[other] = false; }
+            hp[other] = max(hp[other] - dmg, 0);
+            pp[side][m]--;
+            res.outcome = Game::ACT_HIT;
+            res.damage = dmg;
+        }
+        if (defending[side] && power[side][m] > 0) defending[side] = false;
+        return res;
+    }
+};
+
+#ifdef MINIMON_FUZZ
+// ----------------------------- DIFFERENTIAL FUZZER -----------------------------
+// Build with -DMINIMON_FUZZ (host only). Random matchups, seeds and action sequences are played
+// through the reference rules (Game::resolveAction / cpuChooseAction) and through FastBattle, and the
+// full battle state is compared after every turn. A divergence is shrunk to a short repro and printed.
+const long FUZZ_CASES = 200000;
+const int FUZZ_MAX_TURNS = 60;
+
+/*
+    Class: FuzzCase / TurnState
+    Members:
+      - FuzzCase: uint32_t seed, int difficulty, Pokemon a, b, vector<int> actions (-1 = let the CPU choose),
+                  vector<int> reaches (per turn: 1 = the projectile reaches the target, 0 = ACT_NO_HIT)
+      - TurnState: everything observable after a turn (HP, PP, defend flags, outcome, damage)
+*/
+struct FuzzCase {
+    uint32_t seed;
+    int difficulty;
+    Pokemon a, b;
+    vector<int> actions;
+    vector<int> reaches;
+};
+struct TurnState {
+    int hp[2];
+    int pp[2][MAX_MOVES];
+    bool defending[2];
+    int outcome, damage;
+    bool operator==(const TurnState &o) const
+    {
+        return memcmp(hp, o.hp, sizeof(hp)) == 0 && memcmp(pp, o.pp, sizeof(pp)) == 0 &&
+               defending[0] == o.defending[0] && defending[1] == o.defending[1] && outcome == o.outcome && damage == o.damage;
+    }
+};
+
+/*
+    Function: fuzzRand
+    Inputs: uint32_t &state, int n
+    Returns: int in [0, n)
+    Purpose: Case generator randomness, separate from the game's RNG so it never shifts the battle stream.
+*/
+int fuzzRand(uint32_t &state, int n)
+{
+    state ^= state << 13; state ^= state >> 17; state ^= state << 5;
+    return (int)(state % (uint32_t)n);
+}
+
+/*
+    Function: randomFuzzCase
+    Inputs: Game &game, uint32_t &gen
+    Returns: FuzzCase with two perturbed bank species and a random action sequence
+*/
+FuzzCase randomFuzzCase(Game &game, uint32_t &gen)
+{
+    FuzzCase c;
+    c.seed = (uint32_t)fuzzRand(gen, 0x7FFFFFFF);
+    c.difficulty = fuzzRand(gen, 2);
+    Pokemon *mons[2] = { &c.a, &c.b };
+    for (int s = 0; s < 2; ++s) {
+        Pokemon &p = *mons[s];
+        p = game.bank[fuzzRand(gen, (int)game.bank.size())];
+        p.maxHP = 10 + fuzzRand(gen, 70); p.hp = p.maxHP;
+        p.attack = 1 + fuzzRand(gen, 20);
+        p.defense = fuzzRand(gen, 20);
+        p.defending = false;
+        for (auto &m : p.moves) {
+            m.power = fuzzRand(gen, 4) == 0 ? 0 : 10 + fuzzRand(gen, 50);
+            m.accuracy = 30 + fuzzRand(gen, 71);
+            m.pp = fuzzRand(gen, 7);
+        }
+    }
+    int turns = 1 + fuzzRand(gen, FUZZ_MAX_TURNS);
+    for (int t = 0; t < turns; ++t) {
+        int r = fuzzRand(gen, 20);
+        c.actions.push_back(r < 5 ? -1 : r == 19 ? 3 : r % 3);
+        c.reaches.push_back(fuzzRand(gen, 8) != 0);
+    }
+    return c;
+}
+
+/*
+    Function: fuzzReference / fuzzFast
+    Inputs: Game &game, const FuzzCase &c
+    Returns: vector<TurnState> - state after each turn until a faint, a retreat or the actions run out
+    Purpose: Play one case through the reference rules or through FastBattle. The reference runs with
+             animate = true and the projectile stubbed by fuzzProjectile, so ACT_NO_HIT is covered.
+*/
+vector<TurnState> fuzzReference(Game &game, const FuzzCase &c)
+{
+    vector<TurnState> out;
+    game.difficulty = c.difficulty;
+    Pokemon mons[2] = { c.a, c.b };
+    seedRandom(c.seed);
+    for (size_t t = 0; t < c.actions.size(); ++t) {
+        int side = (int)(t % 2);
+        int chosen = c.actions[t] == -1 ? game.cpuChooseAction(mons[side]) : c.actions[t];
+        fuzzProjectile = c.reaches[t];
+        Game::ActionResult res = game.resolveAction(mons[side], mons[1 - side], chosen, true, 1);
+        fuzzProjectile = -1;
+        TurnState st;
+        for (int s = 0; s < 2; ++s) {
+            st.hp[s] = mons[s].hp; st.defending[s] = mons[s].defending;
+            for (int m = 0; m < MAX_MOVES; ++m) st.pp[s][m] = m < (int)mons[s].moves.size() ? mons[s].moves[m].pp : 0;
+        }
+        st.outcome = res.outcome; st.damage = res.damage;
+        out.push_back(st);
+        if (res.outcome == Game::ACT_RETREAT || mons[0].fainted() || mons[1].fainted()) break;
+    }
+    return out;
+}
+
+vector<TurnState> fuzzFast(Game &game, const FuzzCase &c)
+{
+    vector<TurnState> out;
+    game.difficulty = c.difficulty;
+    FastBattle fb;
+    fb.init(game, c.a, c.b);
+    fb.rng.seed(c.seed);
+    for (size_t t = 0; t < c.actions.size(); ++t) {
+        int side = (int)(t % 2);
+        int chosen = c.actions[t] == -1 ? fb.cpuChoose(side) : c.actions[t];
+        Game::ActionResult res = fb.act(side, chosen, c.reaches[t] != 0);
+        TurnState st;
+        for (int s = 0; s < 2; ++s) {
+            st.hp[s] = fb.hp[s]; st.defending[s] = fb.defending[s];
+            for (int m = 0; m < MAX_MOVES; ++m) st.pp[s][m] = m < fb.numMoves[s] ? fb.pp[s][m] : 0;
+        }
+        st.outcome = res.outcome; st.damage = res.damage;
+        out.push_back(st);
+        if (res.outcome == Game::ACT_RETREAT || fb.hp[0] <= 0 || fb.hp[1] <= 0) break;
+    }
+    return out;
+}
+
+/*
+    Function: fuzzDivergence
+    Inputs: Game &game, const FuzzCase &c
+    Returns: int - first turn where the engines disagree, or -1
+*/
+int fuzzDivergence(Game &game, const FuzzCase &c)
+{
+    vector<TurnState> ref = fuzzReference(game, c), fast = fuzzFast(game, c);
+    size_t n = min(ref.size(), fast.size());
+    for (size_t t = 0; t < n; ++t) if (!(ref[t] == fast[t])) return (int)t;
+    return ref.size() == fast.size() ? -1 : (int)n;
+}
+
+/*
+    Function: minimizeFuzzCase
+    Inputs: Game &game, FuzzCase &c (by reference, shrunk in place)
+    Returns: void
+    Purpose: Shrink a diverging case: cut the actions after the divergence, then replace each action
+             with plain move 1 and each blocked projectile with one that reaches, whenever the engines
+             still disagree.
+*/
+void minimizeFuzzCase(Game &game, FuzzCase &c)
+{
+    int turn = fuzzDivergence(game, c);
+    c.actions.resize(turn + 1);
+    c.reaches.resize(turn + 1);
+    for (size_t i = 0; i < c.actions.size(); ++i) {
+        for (int field = 0; field < 2; ++field) {
+            vector<int> &v = field == 0 ? c.actions : c.reaches;
+            int simple = field == 0 ? 0 : 1;
+            if (i >= v.size() || v[i] == simple) continue;
+            FuzzCase trial = c;
+            (field == 0 ? trial.actions : trial.reaches)[i] = simple;
+            int t = fuzzDivergence(game, trial);
+            if (t >= 0) { trial.actions.resize(t + 1); trial.reaches.resize(t + 1); c = trial; }
+        }
+    }
+}
+
+/*
+    Function: printFuzzCase
+    Inputs: const FuzzCase &c
+    Returns: void
+    Purpose: Print a case as a repro.
+*/
+void printFuzzCase(const FuzzCase &c)
+{
+    printf("seed=%u difficulty=%d\n", (unsigned)c.seed, c.difficulty);
+    const Pokemon *mons[2] = { &c.a, &c.b };
+    for (int s = 0; s < 2; ++s) {
+        const Pokemon &p = *mons[s];
+        printf("  side %d: hp=%d atk=%d def=%d moves:", s, p.maxHP, p.attack, p.defense);
+        for (auto &m : p.moves) printf(" [pow=%d acc=%d pp=%d]", m.power, m.accuracy, m.pp);
+        printf("\n");
+    }
+    printf("  actions:");
+    for (int a : c.actions) printf(" %d", a);
+    printf("\n  reaches:");
+    for (int r : c.reaches) printf(" %d", r);
+    printf("\n");
+}
+
+/*
+    Function: runFuzzer
+    Inputs: Game &game, long cases
+    Returns: int process exit status (0 = no divergence)
+*/
+int runFuzzer(Game &game, long cases)
+{
+    uint32_t gen = 0x12345678u;
+    long turns = 0;
+    clock_t start = clock();
+    for (long i = 0; i < cases; ++i) {
+        FuzzCase c = randomFuzzCase(game, gen);
+        turns += (long)c.actions.size();
+        if (fuzzDivergence(game, c) < 0) continue;
+        minimizeFuzzCase(game, c);
+        printf("divergence after %ld cases, minimized repro (diverges at turn %d):\n", i + 1, fuzzDivergence(game, c));
+        printFuzzCase(c);
+        return 1;
+    }
+    double secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf("fuzz: %ld cases, %ld turns, %.0f turns/s, no divergence\n", cases, turns, secs > 0 ? turns / secs : 0.0);
+    return 0;
+}
+#endif
+
+#ifdef MINIMON_BENCH
+// ----------------------------- BENCHMARKS -----------------------------
+// Each benchmark reports ns/op next to per-op hardware counters read through perf_event_open:
+// cycles, instructions, IPC, L1D read misses, LLC misses and branch misses. Counters the kernel
+// refuses (perf_event_paranoid, VMs without a PMU, non-Linux hosts) are shown as "-".
+enum PerfCounterId { PC_CYCLES, PC_INSTRUCTIONS, PC_L1D_MISSES, PC_LLC_MISSES, PC_BRANCH_MISSES, NUM_PERF_COUNTERS };
+volatile long benchSink = 0; // benchmark results land here so the optimizer cannot drop the work
+const int BENCH_BOOT_RUNS = 500;
+const int BENCH_IDLE_MS = 1000; // wall time per idle-wait measurement
+void DrawMainMenuButtons();
+
+/*
+    Class: PerfCounters
+    Members:
+      - int fd[NUM_PERF_COUNTERS] : one perf event per counter, -1 if unavailable
+      - double value[NUM_PERF_COUNTERS] : counts from the last start/stop, scaled for multiplexing
+    Methods:
+      - open() / close(), start() / stop()
+*/
+struct PerfCounters {
+    int fd[NUM_PERF_COUNTERS];
+    double value[NUM_PERF_COUNTERS];
+
+    void open()
+    {
+        for (int i = 0; i < NUM_PERF_COUNTERS; ++i) fd[i] = -1;
+#ifdef __linux__
+        const uint32_t types[NUM_PERF_COUNTERS] = { PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE,
+                                                    PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE };
+        const uint64_t configs[NUM_PERF_COUNTERS] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES };
+        for (int i = 0; i < NUM_PERF_COUNTERS; ++i) {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = types[i];
+            attr.config = configs[i];
+            attr.disabled = 1;
+            attr.exclude_kernel = 1; // user space only, so it works with perf_event_paranoid = 2
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fd[i] = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+        }
+#endif
+    }
+
+    void start()
+    {
+#ifdef __linux__
+        for (int i = 0; i < NUM_PERF_COUNTERS; ++i)
+            if (fd[i] >= 0) { ioctl(fd[i], PERF_EVENT_IOC_RESET, 0); ioctl(fd[i], PERF_EVENT_IOC_ENABLE, 0); }
+#endif
+    }
+
+    void stop()
+    {
+        for (int i = 0; i < NUM_PERF_COUNTERS; ++i) {
+            value[i] = -1;
+#ifdef __linux__
+            if (fd[i] < 0) continue;
+            ioctl(fd[i], PERF_EVENT_IOC_DISABLE, 0);
+            uint64_t buf[3]; // value, time enabled, time running
+            if (read(fd[i], buf, sizeof(buf)) != (ssize_t)sizeof(buf) || buf[2] == 0) continue;
+            value[i] = (double)buf[0] * ((double)buf[1] / (double)buf[2]);
+#endif
+        }
+    }
+
+    void close()
+    {
+#ifdef __linux__
+        for (int i = 0; i < NUM_PERF_COUNTERS; ++i) if (fd[i] >= 0) ::close(fd[i]);
+#endif
+    }
+};
+
+long long benchClockNs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+    Function: runBench
+    Inputs: PerfCounters &pc, const char* name, long ops, F body - body(n) performs n operations
+    Returns: void
+    Purpose: Warm up, then time one measured run of `ops` operations and print a table row.
+*/
+template <typename F>
+void runBench(PerfCounters &pc, const char* name, long ops, F body)
+{
+    body(ops / 10 + 1); // warm caches and branch predictors
+    long long t0 = benchClockNs();
+    pc.start();
+    body(ops);
+    pc.stop();
+    double ns = (double)(benchClockNs() - t0) / ops;
+
+    auto perOp = [&](int id, char *buf, size_t n) {
+        if (pc.value[id] < 0) snprintf(buf, n, "%9s", "-");
+        else snprintf(buf, n, "%9.2f", pc.value[id] / ops);
+    };
+    char cyc[16], ins[16], ipc[16], l1[16], llc[16], br[16];
+    perOp(PC_CYCLES, cyc, sizeof(cyc));
+    perOp(PC_INSTRUCTIONS, ins, sizeof(ins));
+    perOp(PC_L1D_MISSES, l1, sizeof(l1));
+    perOp(PC_LLC_MISSES, llc, sizeof(llc));
+    perOp(PC_BRANCH_MISSES, br, sizeof(br));
+    if (pc.value[PC_CYCLES] > 0 && pc.value[PC_INSTRUCTIONS] >= 0) snprintf(ipc, sizeof(ipc), "%5.2f", pc.value[PC_INSTRUCTIONS] / pc.value[PC_CYCLES]);
+    else snprintf(ipc, sizeof(ipc), "%5s", "-");
+    printf("%-22s %10.1f %s %s %s %s %s %s\n", name, ns, cyc, ins, ipc, l1, llc, br);
+}
+
+/*
+    Function: benchPercentile
+    Inputs: vector<long long> samples (sorted by this call), double p (0..100)
+    Returns: long long - nearest-rank percentile
+*/
+long long benchPercentile(vector<long long> &samples, double p)
+{
+    sort(samples.begin(), samples.end());
+    size_t rank = (size_t)(p / 100.0 * samples.size() + 0.999999);
+    return samples[min(max(rank, (size_t)1), samples.size()) - 1];
+}
+
+/*
+    Function: benchSpritePrimitives
+    Inputs: const Pokemon &p, bool flip
+    Returns: void
+    Purpose: The hand-composed body + eye shape sprites were drawn with before RLE art, kept as a baseline.
+*/
+void benchSpritePrimitives(const Pokemon &p, bool flip)
+{
+    Screen.SetFontColor(p.color);
+    Screen.FillRectangle(p.x, p.y, p.w, p.h);
+    int cx = p.x + (flip ? p.w / 4 : 3 * p.w / 4), cy = p.y + p.h / 4;
+    Screen.SetFontColor(BLACK);
+    Screen.FillRectangle(cx - 2, cy - 2, 4, 4);
+}
+
+/*
+    Function: benchSpriteRuns
+    Inputs: const SpriteAsset &s, int x, int y, int bodyColor, bool flip
+    Returns: void
+    Purpose: Draw straight from the RLE runs, one filled rectangle per visible run, as a baseline for drawSprite.
+*/
+void benchSpriteRuns(const SpriteAsset &s, int x, int y, int bodyColor, bool flip)
+{
+    const int palette[4] = { 0, bodyColor, BLACK, WHITE };
+    int col = 0, row = 0;
+    for (int i = 0; i < s.numRuns; ++i) {
+        int len = s.runs[i] >> 2, color = s.runs[i] & 3;
+        if (color != 0) {
+            Screen.SetFontColor(palette[color]);
+            Screen.FillRectangle(x + (flip ? s.cols - col - len : col) * SPRITE_SCALE, y + row * SPRITE_SCALE, len * SPRITE_SCALE, SPRITE_SCALE);
+        }
+        col += len;
+        if (col >= s.cols) { col = 0; row++; }
+    }
+}
+
+/*
+    Function: runBenchmarks
+    Inputs: Game &game
+    Returns: int process exit status
+    Purpose: Damage kernel, KO odds, CPU policy, reference vs FastBattle headless battles and frame rendering.
+*/
+int runBenchmarks(Game &game)
+{
+    PerfCounters pc;
+    pc.open();
+    seedRandom(1);
+    const vector<Pokemon> &bank = game.bank;
+    int n = (int)bank.size();
+
+    printf("%-22s %10s %9s %9s %5s %9s %9s %9s\n", "benchmark (per op)", "ns", "cycles", "instr", "IPC", "L1D-miss", "LLC-miss", "br-miss");
+    runBench(pc, "damageForRoll", 2000000, [&](long ops) {
+        long sum = 0;
+        for (long i = 0; i < ops; ++i) {
+            const Pokemon &a = bank[i % n], &d = bank[(i / n) % n];
+            sum += game.damageForRoll(a, d, a.moves[i % a.moves.size()], DAMAGE_ROLL_MIN + (int)(i % NUM_DAMAGE_ROLLS));
+        }
+        benchSink += sum;
+    });
+    runBench(pc, "computeDamage", 2000000, [&](long ops) {
+        long sum = 0;
+        for (long i = 0; i < ops; ++i) {
+            const Pokemon &a = bank[i % n], &d = bank[(i / n) % n];
+            sum += game.computeDamage(a, d, a.moves[i % a.moves.size()]);
+        }
+        benchSink += sum;
+    });
+    runBench(pc, "koChance (uncached)", 20000, [&](long ops) {
+        double sum = 0;
+        for (long i = 0; i < ops; ++i) {
+            const Pokemon &a = bank[i % n], &d = bank[(i / n) % n];
+            game.clearKoCache();
+            sum += game.koChance(a, d, a.moves[0], MATCHUP_HITS);
+        }
+        benchSink += (long)sum;
+    });
+    for (int diff = 0; diff < 2; ++diff) {
+        game.difficulty = diff;
+        runBench(pc, diff == 0 ? "cpuChooseAction easy" : "cpuChooseAction hard", 2000000, [&](long ops) {
+            long sum = 0;
+            for (long i = 0; i < ops; ++i) sum += game.cpuChooseAction(bank[i % n]);
+            benchSink += sum;
+        });
+    }
+    runBench(pc, "flightRecord", 2000000, [&](long ops) {
+        for (long i = 0; i < ops; ++i) flightRecord(FR_ACTION, (int)(i & 1), (int)(i & 3), (int)i);
+        benchSink += flightCount;
+    });
+    runBench(pc, "randInt", 2000000, [&](long ops) {
+        long sum = 0;
+        for (long i = 0; i < ops; ++i) sum += randInt(1, 100);
+        benchSink += sum;
+    });
+    runBench(pc, "RandomBlock::range", 2000000, [&](long ops) {
+        RandomBlock rb;
+        rb.seed(1);
+        long sum = 0;
+        for (long i = 0; i < ops; ++i) sum += rb.range(1, 100);
+        benchSink += sum;
+    });
+    game.difficulty = 1;
+    runBench(pc, "battle (reference)", 20000, [&](long ops) {
+        long turns = 0;
+        for (long i = 0; i < ops; ++i) {
+            Pokemon mons[2] = { bank[i % n], bank[(i + 1 + i / n) % n] };
+            for (int t = 0; t < 200 && !mons[0].fainted() && !mons[1].fainted(); ++t, ++turns) {
+                int side = t % 2, chosen = game.cpuChooseAction(mons[side]);
+                if (chosen == 3) continue; // keep fighting: a retreat would end the match early
+                game.resolveAction(mons[side], mons[1 - side], chosen, false, 1);
+            }
+        }
+        benchSink += turns;
+    });
+    runBench(pc, "battle (FastBattle)", 20000, [&](long ops) {
+        long turns = 0;
+        FastBattle fb;
+        fb.rng.seed(1);
+        for (long i = 0; i < ops; ++i) {
+            fb.init(game, bank[i % n], bank[(i + 1 + i / n) % n]);
+            for (int t = 0; t < 200 && fb.hp[0] > 0 && fb.hp[1] > 0; ++t, ++turns) {
+                int side = t % 2, chosen = fb.cpuChoose(side);
+                if (chosen == 3) continue;
+                fb.act(side, chosen);
+            }
+        }
+        benchSink += turns;
+    });
+
+    // sprite drawing: the old primitive shapes, raw RLE runs and drawSprite's merged spans
+    game.assignPlayers();
+    const Pokemon &mon = game.p1.pkmn;
+    int fills[3];
+    for (int k = 0; k < 3; ++k) {
+        watchdog.draws[DRAW_FILL] = 0;
+        if (k == 0) benchSpritePrimitives(mon, false);
+        else if (k == 1) benchSpriteRuns(MON_SPRITE, mon.x, mon.y, mon.color, false);
+        else game.drawSprite(MON_SPRITE, mon.x, mon.y, mon.color, false);
+        fills[k] = watchdog.draws[DRAW_FILL];
+    }
+    runBench(pc, "sprite (primitives)", 200000, [&](long ops) {
+        for (long i = 0; i < ops; ++i) benchSpritePrimitives(mon, i & 1);
+    });
+    runBench(pc, "sprite (RLE runs)", 200000, [&](long ops) {
+        for (long i = 0; i < ops; ++i) benchSpriteRuns(MON_SPRITE, mon.x, mon.y, mon.color, i & 1);
+    });
+    runBench(pc, "sprite (RLE merged)", 200000, [&](long ops) {
+        for (long i = 0; i < ops; ++i) game.drawSprite(MON_SPRITE, mon.x, mon.y, mon.color, i & 1);
+    });
+    printf("sprite fills/draw: primitives %d, RLE runs %d, RLE merged %d\n", fills[0], fills[1], fills[2]);
+
+    // frame render: what one projectile step costs (effects-layer dirty rects + composite + flush)
+    game.buildBackgroundLayer();
+    runBench(pc, "frame (projectile)", 20000, [&](long ops) {
+        for (long i = 0; i < ops; ++i) {
+            if (game.fxActive) game.markDirty(game.fxRect);
+            game.fxRect = {(int)(20 + (i * PROJECTILE_STEP_PX) % 280), 90, 8, 8};
+            game.fxActive = true;
+            game.markDirty(game.fxRect);
+            game.composite();
+            Screen.Update();
+        }
+        game.fxActive = false;
+    });
+    runBench(pc, "frame (full battle)", 2000, [&](long ops) {
+        for (long i = 0; i < ops; ++i) {
+            game.markDirty({0, 0, SCREEN_W, SCREEN_H});
+            game.composite();
+            Screen.Update();
+        }
+    });
+
+    // cold start: a fresh Game up to the first presented menu frame, then the deferred init
+    vector<long long> toMenu, deferred;
+    for (int i = 0; i < BENCH_BOOT_RUNS; ++i) {
+        long long t0 = benchClockNs();
+        Game cold;
+        DrawMainMenuButtons();
+        long long t1 = benchClockNs();
+        cold.finishStartup();
+        deferred.push_back(benchClockNs() - t1);
+        toMenu.push_back(t1 - t0);
+    }
+    long long menuP50 = benchPercentile(toMenu, 50), menuP99 = benchPercentile(toMenu, 99);
+    long long initP50 = benchPercentile(deferred, 50), initP99 = benchPercentile(deferred, 99);
+    printf("boot to menu (%d runs): p50 %.1f us, p99 %.1f us, max %.1f us (budget %d ms)\n", BENCH_BOOT_RUNS,
+           menuP50 / 1e3, menuP99 / 1e3, toMenu.back() / 1e3, STARTUP_MENU_BUDGET_MS);
+    printf("deferred init:             p50 %.1f us, p99 %.1f us, max %.1f us\n",
+           initP50 / 1e3, initP99 / 1e3, deferred.back() / 1e3);
+
+    // idle waits: CPU time used while nobody touches the screen, old spin-poll vs the idle manager
+    // (slow-tick case measured by pretending the last input was long ago)
+    int tx, ty;
+    const char* idleNames[3] = { "spin poll", "idle tick", "idle slow tick" };
+    for (int mode = 0; mode < 3; ++mode) {
+        lastInputMs = mode == 2 ? NowMs() - IDLE_SLOW_AFTER_MS - 1 : NowMs();
+        long polls = 0;
+        clock_t cpu0 = clock();
+        long long wall0 = benchClockNs(), until = NowMs() + BENCH_IDLE_MS;
+        while (NowMs() < until) {
+            if (mode == 0) ReadTouch(tx, ty);
+            else PollTouchIdle(tx, ty);
+            if (mode == 1) lastInputMs = NowMs(); // stay on the active tick
+            polls++;
+        }
+        double cpu = (double)(clock() - cpu0) / CLOCKS_PER_SEC, wall = (benchClockNs() - wall0) / 1e9;
+        printf("idle wait (%-14s): %5.1f%% CPU, %ld polls/s\n", idleNames[mode], 100.0 * cpu / wall, (long)(polls / wall));
+    }
+    pc.close();
+    return 0;
+}
+#endif
+
+#ifdef MINIMON_BALANCE
+// ----------------------------- BALANCE REPORT -----------------------------
+// Host tool for tuning loadBank. Brings the matchup matrix up to date, reusing every cell in
+// MATCHUP_CACHE_FILE whose species did not change, prints it and saves it for the next run. Then ranks
+// the +1/-1 stat tweaks that move matchup cells the most (Game::statSensitivity).
+const size_t BALANCE_TOP_TWEAKS = 20;
+
+/*
+    Function: runBalance
+    Inputs: Game &game (bank loaded)
+    Returns: int process exit status
+*/
+int runBalance(Game &game)
+{
+    int n = (int)game.bank.size();
+    int restored = game.loadMatchupCache();
+    int threads = max(1, (int)std::thread::hardware_concurrency());
+    auto start = std::chrono::steady_clock::now();
+    int recomputed = game.refreshMatchups(threads);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("matchups: %d cells from %s, %d of %d recomputed in %.2f ms (%d threads)\n", restored, MATCHUP_CACHE_FILE,
+           recomputed, n * n, ms, threads);
+
+    printf("\nchance the row species knocks out the column species within %d uses of its best move\n%-11s", MATCHUP_HITS, "");
+    for (int j = 0; j < n; ++j) printf(" %10.10s", game.bank[j].name.c_str());
+    printf("\n");
+    for (int i = 0; i < n; ++i) {
+        printf("%-11.11s", game.bank[i].name.c_str());
+        for (int j = 0; j < n; ++j) {
+            if (i == j) printf(" %10s", "-");
+            else printf(" %9.1f%%", 100.0 * game.matchup[i * n + j].chance);
+        }
+        printf("\n");
+    }
+    game.saveMatchupCache();
+
+    // stat sensitivities of every matchup, dealt out round-robin to threads that each own a copy of the game
+    vector<pair<int, int>> pairs;
+    for (int i = 0; i < n; ++i) for (int j = 0; j < n; ++j) if (i != j) pairs.push_back(make_pair(i, j));
+    vector<vector<Game::StatSensitivity>> report(pairs.size());
+    threads = max(1, min(threads, (int)pairs.size()));
+    vector<Game> solvers(threads, game);
+    auto solve = [&pairs, &report](Game &solver, size_t first, size_t step) {
+        for (size_t k = first; k < pairs.size(); k += step) report[k] = solver.statSensitivity(pairs[k].first, pairs[k].second);
+    };
+    start = std::chrono::steady_clock::now();
+    vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) pool.push_back(std::thread(solve, std::ref(solvers[t]), (size_t)t, (size_t)threads));
+    solve(solvers[0], 0, threads);
+    for (auto &th : pool) th.join();
+    ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // one ranked list over all matchups: the single-point tweaks that move a cell the most
+    struct Tweak { size_t pair; const Game::StatSensitivity *s; };
+    vector<Tweak> tweaks;
+    for (size_t k = 0; k < report.size(); ++k) for (auto &e : report[k]) tweaks.push_back({k, &e});
+    std::sort(tweaks.begin(), tweaks.end(), [](const Tweak &x, const Tweak &y) { return x.s->effect() > y.s->effect(); });
+    printf("\nmost effective single-point tweaks (%zu stats over %zu matchups in %.2f ms):\n", tweaks.size(), pairs.size(), ms);
+    for (size_t k = 0; k < tweaks.size() && k < BALANCE_TOP_TWEAKS; ++k) {
+        const Game::StatSensitivity &e = *tweaks[k].s;
+        const Pokemon &a = game.bank[pairs[tweaks[k].pair].first], &d = game.bank[pairs[tweaks[k].pair].second];
+        char up[16] = "at limit", down[16] = "at limit";
+        if (e.canRaise) snprintf(up, sizeof(up), "%+.1f%%", 100.0 * e.up);
+        if (e.canLower) snprintf(down, sizeof(down), "%+.1f%%", 100.0 * e.down);
+        printf("  %-30s %-10s vs %-10s  +1: %-9s -1: %s\n", e.label.c_str(), a.name.c_str(), d.name.c_str(), up, down);
+    }
+    return 0;
+}
+#endif
+
+#ifdef MINIMON_SIM
+// ----------------------------- ASYNC FILE WRITER -----------------------------
+// Appends are copied into WRITER_BUFFERS aligned buffers of WRITER_BUFFER_BYTES. A full buffer is
+// handed to the I/O backend and the caller moves on to the next free one, so it only ever waits
+// when every buffer is still in flight (backpressure instead of unbounded memory). Backends:
+//   - io_uring (Linux): one IORING_OP_WRITE per buffer through raw io_uring_setup/io_uring_enter,
+//     so a syscall moves a whole megabyte. No liburing needed.
+//   - thread + pwrite: fallback where io_uring is missing or refused, or forced with -DMINIMON_NO_URING.
+// The file is opened with O_DIRECT when the filesystem allows it; the last partial buffer is padded
+// to the alignment and the file truncated back to its real length on close.
+const size_t WRITER_BUFFER_BYTES = 1 << 20;
+const int WRITER_BUFFERS = 8;
+const size_t WRITER_ALIGN = 4096;
+
+/*
+    Class: AsyncWriter
+    Methods:
+      - open(path, resume) : create/truncate the file (or, with resume, append after its current end) and
+                             start a backend; false if the file cannot be opened
+      - append(data, len) : copy bytes into the current buffer, submitting it whenever it fills
+      - close() : write the partial buffer, wait for all writes, fix the length; false on any write error
+      - backendName() : "io_uring" or "pwrite thread"
+      - bytesWritten : payload bytes appended so far
+*/
+class AsyncWriter {
+public:
+    uint64_t bytesWritten;
+
+    AsyncWriter(): bytesWritten(0), fd(-1), fileOffset(0), cur(-1), fill(0), inFlight(0), failed(false),
+                   useUring(false), stopping(false) {}
+
+    bool open(const char* path, bool resume = false)
+    {
+        int flags = O_WRONLY | O_CREAT | (resume ? 0 : O_TRUNC);
+        fd = ::open(path, flags | O_DIRECT, 0644);
+        if (fd < 0) fd = ::open(path, flags, 0644); // tmpfs and friends refuse O_DIRECT
+        if (fd < 0) return false;
+        for (int i = 0; i < WRITER_BUFFERS; ++i) {
+            void *p = nullptr;
+            if (posix_memalign(&p, WRITER_ALIGN, WRITER_BUFFER_BYTES) != 0) return false;
+            bufs[i] = static_cast<char*>(p);
+            freeBufs.push_back(i);
+        }
+#if defined(__linux__) && !defined(MINIMON_NO_URING)
+        useUring = uringSetup(WRITER_BUFFERS);
+#endif
+        if (!useUring) ioThread = std::thread(&AsyncWriter::ioThreadMain, this);
+        cur = takeFreeBuffer();
+        if (resume) {
+            // O_DIRECT writes must start on a block: begin at the last whole block and carry the
+            // bytes already on disk after it in the first buffer, so they are rewritten unchanged
+            off_t end = lseek(fd, 0, SEEK_END);
+            if (end < 0) return false;
+            fileOffset = (uint64_t)end / WRITER_ALIGN * WRITER_ALIGN;
+            fill = (size_t)((uint64_t)end - fileOffset);
+            int rd = ::open(path, O_RDONLY);
+            bool ok = rd >= 0 && pread(rd, bufs[cur], fill, (off_t)fileOffset) == (ssize_t)fill;
+            if (rd >= 0) ::close(rd);
+            if (!ok) return false;
+        }
+        return true;
+    }
+
+    void append(const void *data, size_t len)
+    {
+        const char *src = static_cast<const char*>(data);
+        bytesWritten += len;
+        while (len > 0) {
+            size_t n = min(len, WRITER_BUFFER_BYTES - fill);
+            memcpy(bufs[cur] + fill, src, n);
+            fill += n; src += n; len -= n;
+            if (fill == WRITER_BUFFER_BYTES) { submit(cur, fill); cur = takeFreeBuffer(); fill = 0; }
+        }
+    }
+
+    bool close()
+    {
+        uint64_t length = fileOffset + fill;
+        if (fill > 0) {
+            size_t padded = (fill + WRITER_ALIGN - 1) / WRITER_ALIGN * WRITER_ALIGN;
+            memset(bufs[cur] + fill, 0, padded - fill);
+            submit(cur, padded);
+        } else {
+            releaseBuffer(cur);
+        }
+        if (useUring) {
+#if defined(__linux__) && !defined(MINIMON_NO_URING)
+            while (inFlight > 0) uringReap(true);
+            uringTeardown();
+#endif
+        } else {
+            { std::lock_guard<std::mutex> lock(mu); stopping = true; }
+            jobReady.notify_one();
+            ioThread.join();
+        }
+        if (ftruncate(fd, (off_t)length) != 0) failed = true;
+        ::close(fd);
+        for (int i = 0; i < WRITER_BUFFERS; ++i) free(bufs[i]);
+        return !failed;
+    }
+
+    const char* backendName() const { return useUring ? "io_uring" : "pwrite thread"; }
+
+private:
+    struct WriteJob { int buf; size_t len; uint64_t offset; };
+
+    int fd;
+    uint64_t fileOffset;      // where the next submitted buffer goes
+    char *bufs[WRITER_BUFFERS];
+    int cur;                  // buffer being filled
+    size_t fill;
+    int inFlight;             // io_uring writes submitted and not yet reaped
+    bool failed;
+    bool useUring;
+
+    // free buffers; shared with the I/O thread in the fallback backend
+    std::mutex mu;
+    std::condition_variable bufferFree, jobReady;
+    deque<int> freeBufs;
+    deque<WriteJob> jobs;
+    bool stopping;
+    std::thread ioThread;
+
+    int takeFreeBuffer()
+    {
+        if (useUring) {
+#if defined(__linux__) && !defined(MINIMON_NO_URING)
+            while (freeBufs.empty()) uringReap(true);
+#endif
+        } else {
+            std::unique_lock<std::mutex> lock(mu);
+            bufferFree.wait(lock, [this] { return !freeBufs.empty(); });
+        }
+        std::lock_guard<std::mutex> lock(mu);
+        int b = freeBufs.front();
+        freeBufs.pop_front();
+        return b;
+    }
+
+    void releaseBuffer(int b)
+    {
+        { std::lock_guard<std::mutex> lock(mu); freeBufs.push_back(b); }
+        bufferFree.notify_one();
+    }
+
+    void submit(int buf, size_t len)
+    {
+        WriteJob job = {buf, len, fileOffset};
+        fileOffset += len;
+        if (useUring) {
+#if defined(__linux__) && !defined(MINIMON_NO_URING)
+            uringSubmit(job);
+            uringReap(false);
+#endif
+            return;
+        }
+        { std::lock_guard<std::mutex> lock(mu); jobs.push_back(job); }
+        jobReady.notify_one();
+    }
+
+    static bool writeAll(int fd, const char *p, size_t len, uint64_t offset)
+    {
+        while (len > 0) {
+            ssize_t n = pwrite(fd, p, len, (off_t)offset);
+            if (n <= 0) return false;
+            p += n; len -= (size_t)n; offset += (uint64_t)n;
+        }
+        return true;
+    }
+
+    void ioThreadMain()
+    {
+        while (true) {
+            WriteJob job;
+            {
+                std::unique_lock<std::mutex> lock(mu);
+                jobReady.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (jobs.empty()) return; // stopping and drained
+                job = jobs.front();
+                jobs.pop_front();
+            }
+            if (!writeAll(fd, bufs[job.buf], job.len, job.offset)) failed = true;
+            releaseBuffer(job.buf);
+        }
+    }
+
+#if defined(__linux__) && !defined(MINIMON_NO_URING)
+    int ringFd = -1;
+    void *sqRing = nullptr, *cqRing = nullptr;
+    size_t sqRingBytes = 0, cqRingBytes = 0, sqesBytes = 0;
+    unsigned *sqTail = nullptr, *sqMask = nullptr, *sqArray = nullptr;
+    unsigned *cqHead = nullptr, *cqTail = nullptr, *cqMask = nullptr;
+    io_uring_sqe *sqes = nullptr;
+    io_uring_cqe *cqes = nullptr;
+    WriteJob pending[WRITER_BUFFERS]; // by buffer index, to finish short writes
+
+    bool uringSetup(unsigned entries)
+    {
+        io_uring_params p;
+        memset(&p, 0, sizeof(p));
+        ringFd = (int)syscall(__NR_io_uring_setup, entries, &p);
+        if (ringFd < 0) return false;
+        sqRingBytes = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cqRingBytes = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single) sqRingBytes = cqRingBytes = max(sqRingBytes, cqRingBytes);
+        sqRing = mmap(nullptr, sqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+        cqRing = single ? sqRing : mmap(nullptr, cqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+        sqesBytes = p.sq_entries * sizeof(io_uring_sqe);
+        void *sq = mmap(nullptr, sqesBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+        if (sqRing == MAP_FAILED || cqRing == MAP_FAILED || sq == MAP_FAILED) { ::close(ringFd); ringFd = -1; return false; }
+        char *sb = static_cast<char*>(sqRing), *cb = static_cast<char*>(cqRing);
+        sqTail = (unsigned*)(sb + p.sq_off.tail); sqMask = (unsigned*)(sb + p.sq_off.ring_mask);
+        sqArray = (unsigned*)(sb + p.sq_off.array);
+        cqHead = (unsigned*)(cb + p.cq_off.head); cqTail = (unsigned*)(cb + p.cq_off.tail);
+        cqMask = (unsigned*)(cb + p.cq_off.ring_mask);
+        cqes = (io_uring_cqe*)(cb + p.cq_off.cqes);
+        sqes = static_cast<io_uring_sqe*>(sq);
+        return true;
+    }
+
+    void uringSubmit(const WriteJob &job)
+    {
+        pending[job.buf] = job;
+        unsigned tail = *sqTail, idx = tail & *sqMask;
+        io_uring_sqe &e = sqes[idx];
+        memset(&e, 0, sizeof(e));
+        e.opcode = IORING_OP_WRITE;
+        e.fd = fd;
+        e.addr = (uint64_t)(uintptr_t)bufs[job.buf];
+        e.len = (uint32_t)job.len;
+        e.off = job.offset;
+        e.user_data = (uint64_t)job.buf;
+        sqArray[idx] = idx;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+        if (syscall(__NR_io_uring_enter, ringFd, 1, 0, 0, nullptr, 0) < 0) {
+            // the kernel refused the submission: write it synchronously rather than lose it
+            __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+            if (!writeAll(fd, bufs[job.buf], job.len, job.offset)) failed = true;
+            releaseBuffer(job.buf);
+            return;
+        }
+        inFlight++;
+    }
+
+    void uringReap(bool wait)
+    {
+        if (wait && inFlight > 0) syscall(__NR_io_uring_enter, ringFd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        unsigned head = *cqHead, tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            const io_uring_cqe &c = cqes[head & *cqMask];
+            WriteJob &job = pending[(int)c.user_data];
+            if (c.res < 0) failed = true;
+            else if ((size_t)c.res < job.len && // short write: finish the rest synchronously
+                     !writeAll(fd, bufs[job.buf] + c.res, job.len - c.res, job.offset + c.res)) failed = true;
+            inFlight--;
+            releaseBuffer(job.buf);
+        }
+        __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+    }
+
+    void uringTeardown()
+    {
+        munmap(sqes, sqesBytes);
+        if (cqRing != sqRing) munmap(cqRing, cqRingBytes);
+        munmap(sqRing, sqRingBytes);
+        ::close(ringFd);
+    }
+#endif
+};
+
+// ----------------------------- FRAMED COMPRESSION -----------------------------
+// CompressedWriter sits in front of AsyncWriter. Appends fill CHUNK_BYTES chunks. Full chunks go
+// through a bounded queue (the producer waits when it is full) to a small thread pool that compresses
+// them, and finished frames are written strictly in chunk order. Each frame is self-contained:
+//   FrameHeader (20 bytes) + payload
+// so a reader can decode a file that is still being written, frame by frame, stopping at the first
+// frame that is not complete yet (FramedReader). The codec is a byte-oriented LZ77 in the style of
+// LZ4 (token with literal/match lengths, 16-bit offsets); for fixed-size records a shuffle filter
+// first groups byte k of every record together, which is what makes struct data compress well.
+// Levels: 0 = store, 1 = fast (one hash probe), 2..9 = hash chains searched 2^level deep.
+#ifndef MINIMON_COMPRESS_LEVEL
+#define MINIMON_COMPRESS_LEVEL 1
+#endif
+const size_t CHUNK_BYTES = 256 * 1024;
+const int COMPRESS_QUEUE_DEPTH = 8; // chunks waiting for a compression thread
+const int LZ_MIN_MATCH = 4;
+const int LZ_HASH_BITS = 14;
+const size_t LZ_WINDOW = 65535;
+enum FrameCodec { CODEC_STORE, CODEC_LZ, CODEC_SHUFFLE_LZ };
+
+/*
+    Class: FrameHeader
+    Members:
+      - char magic[4] : "MMF1"
+      - uint32_t rawLen, payloadLen : sizes before and after compression
+      - uint32_t checksum : of the raw bytes, so a half-written frame is never accepted
+      - uint8_t codec, level, stride : FrameCodec, compression level, record size for the shuffle filter
+*/
+struct FrameHeader {
+    char magic[4];
+    uint32_t rawLen, payloadLen, checksum;
+    uint8_t codec, level, stride, reserved;
+};
+static_assert(sizeof(FrameHeader) == 20, "FrameHeader is a fixed 20-byte header");
+
+uint32_t frameChecksum(const uint8_t *p, size_t n)
+{
+    uint32_t h = 2166136261u;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) { uint32_t w; memcpy(&w, p + i, 4); h = (h ^ w) * 16777619u; }
+    for (; i < n; ++i) h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+inline uint32_t lzRead32(const uint8_t *p) { uint32_t v; memcpy(&v, p, 4); return v; }
+inline uint32_t lzHash(uint32_t v) { return (v * 2654435761u) >> (32 - LZ_HASH_BITS); }
+
+void lzPutLength(vector<uint8_t> &out, size_t len)
+{
+    for (; len >= 255; len -= 255) out.push_back(255);
+    out.push_back((uint8_t)len);
+}
 
-    /*
-        Function: drawPokemonGraphic
-        Inputs: const Pokemon &p, bool flip (if true, draw mirrored)
-        Returns: void
-        Purpose: Draws a simple composed graphic representing the Pokémon using shapes.
-                 Uses rectangle(s), filled rectangle, and circle (if available).
-        Author: Aadit Bhatia
-    */
-    void drawPokemonGraphic(const Pokemon &p, bool flip=false)
-    {
-        // background box
-        LCD.SetFontColor(WHITE);
-        LCD.DrawRectangle(p.x - 6, p.y - 6, p.w + 12, p.h + 12);
-        // filled body rectangle as the "sprite"
-        LCD.SetFontColor(GREEN); // body color (choice varies)
-        LCD.FillRectangle(p.x, p.y, p.w, p.h);
-
-        // small "eye" as a circle or pixel (try DrawCircle, otherwise fall back)
-        LCD.SetFontColor(BLACK);
-        int cx = p.x + (flip ? p.w/4 : 3*p.w/4);
-        int cy = p.y + p.h/4;
-        LCD.FillRectangle(cx-2, cy-2, 4, 4);
+/*
+    Function: lzCompress
+    Inputs: const uint8_t *src, size_t n, vector<uint8_t> &out, int level (1..9)
+    Returns: void (out holds the compressed sequences)
+    Purpose: Greedy LZ77. Sequence = token (literal length << 4 | match length - 4), literal length
+             extension, literals, 16-bit offset, match length extension. The last sequence has literals only.
+*/
+void lzCompress(const uint8_t *src, size_t n, vector<uint8_t> &out, int level)
+{
+    out.clear();
+    out.reserve(n + n / 255 + 16);
+    vector<int32_t> head(1 << LZ_HASH_BITS, -1), chain(level > 1 ? n : 0);
+    int depth = level > 1 ? 1 << min(level, 9) : 1;
+    size_t anchor = 0, i = 0;
+    auto insert = [&](size_t pos) {
+        uint32_t h = lzHash(lzRead32(src + pos));
+        if (level > 1) chain[pos] = head[h];
+        head[h] = (int32_t)pos;
+    };
+    while (i + LZ_MIN_MATCH <= n) {
+        size_t bestLen = 0, bestOff = 0;
+        int32_t cand = head[lzHash(lzRead32(src + i))];
+        for (int d = 0; d < depth && cand >= 0 && i - (size_t)cand <= LZ_WINDOW; ++d) {
+            size_t len = 0;
+            while (i + len < n && src[cand + len] == src[i + len]) ++len;
+            if (len > bestLen) { bestLen = len; bestOff = i - cand; }
+            cand = level > 1 ? chain[cand] : -1;
+        }
+        insert(i);
+        if (bestLen < (size_t)LZ_MIN_MATCH) { ++i; continue; }
 
-        // add a little "health bar" on top of box as a filled rectangle 
-        int barW = p.w;
-        int hpperc = (p.hp * barW) / p.maxHP;
-        LCD.SetFontColor(RED);
-        LCD.FillRectangle(p.x, p.y - 10, barW, 6);
-        LCD.SetFontColor(GREEN);
-        LCD.FillRectangle(p.x, p.y - 10, hpperc, 6);
+        size_t lit = i - anchor, ml = bestLen - LZ_MIN_MATCH;
+        out.push_back((uint8_t)((min(lit, (size_t)15) << 4) | min(ml, (size_t)15)));
+        if (lit >= 15) lzPutLength(out, lit - 15);
+        out.insert(out.end(), src + anchor, src + i);
+        out.push_back((uint8_t)(bestOff & 0xFF));
+        out.push_back((uint8_t)(bestOff >> 8));
+        if (ml >= 15) lzPutLength(out, ml - 15);
+        if (level > 1) for (size_t k = i + 1; k < i + bestLen && k + LZ_MIN_MATCH <= n; ++k) insert(k);
+        i += bestLen;
+        anchor = i;
     }
+    size_t lit = n - anchor;
+    out.push_back((uint8_t)(min(lit, (size_t)15) << 4));
+    if (lit >= 15) lzPutLength(out, lit - 15);
+    out.insert(out.end(), src + anchor, src + n);
+}
 
-    /*
-        Function: drawBackground
-        Inputs: none
-        Returns: void
-        Purpose: Draw a simple background composed of shapes (meets Basic+Advanced Graphics).
-                 Uses multiple rectangles and a ground band.
-        Author: Pranav Rajesh
-    */
-    void drawBackground()
-    {
-        LCD.Clear(BLUE); // sky
-        // ground band
-        LCD.SetFontColor(BROWN);
-        LCD.FillRectangle(0, 160, SCREEN_W, 80);
-        // a simple sun (circle or filled rect)
-        LCD.SetFontColor(YELLOW);
-        // If DrawCircle available, use it; else use FillRectangle as sun
-        LCD.FillRectangle(260, 12, 34, 34);
-        // horizon line
-        LCD.SetFontColor(WHITE);
-        LCD.DrawRectangle(10, 10, 60, 30);
+/*
+    Function: lzDecompress
+    Inputs: const uint8_t *src, size_t n, uint8_t *dst, size_t rawLen
+    Returns: bool (false if the data is malformed)
+*/
+bool lzDecompress(const uint8_t *src, size_t n, uint8_t *dst, size_t rawLen)
+{
+    size_t ip = 0, op = 0;
+    auto readLength = [&](size_t len) -> size_t {
+        uint8_t b;
+        do { if (ip >= n) return (size_t)-1; b = src[ip++]; len += b; } while (b == 255);
+        return len;
+    };
+    while (ip < n) {
+        uint8_t token = src[ip++];
+        size_t lit = token >> 4;
+        if (lit == 15 && (lit = readLength(lit)) == (size_t)-1) return false;
+        if (lit > n - ip || lit > rawLen - op) return false;
+        memcpy(dst + op, src + ip, lit);
+        ip += lit; op += lit;
+        if (ip == n) break; // last sequence: literals only
+        if (n - ip < 2) return false;
+        size_t off = src[ip] | (src[ip + 1] << 8);
+        ip += 2;
+        size_t ml = token & 15;
+        if (ml == 15 && (ml = readLength(ml)) == (size_t)-1) return false;
+        ml += LZ_MIN_MATCH;
+        if (off == 0 || off > op || ml > rawLen - op) return false;
+        for (size_t k = 0; k < ml; ++k, ++op) dst[op] = dst[op - off]; // byte copy: matches may overlap
     }
+    return op == rawLen;
+}
 
-    /*
-        Function: drawBattleStatus
-        Inputs: const Player &p1, const Player &p2
-        Returns: void
-        Purpose: Draws the HP and name text in the designated status area.
-        Author: Pranav Rajesh
-    */
-    void drawBattleStatus(const Player &p1, const Player &p2) {
-        LCD.SetFontColor(BLUE); // Clear the area where status text will go
-        LCD.FillRectangle(0, STATUS_TEXT_Y - 5, SCREEN_W, BBTN_START_Y - STATUS_TEXT_Y + 5);
-       
-        LCD.SetFontColor(WHITE);
-        // Player 1 Status (Left)
-        LCD.WriteAt((p1.pkmn.name + " (P1)").c_str(), 8, STATUS_TEXT_Y);
-        LCD.WriteAt(("HP: " + to_string(p1.pkmn.hp) + "/" + to_string(p1.pkmn.maxHP)).c_str(), 8, STATUS_TEXT_Y + 14);
+/*
+    Function: shuffleRecords / unshuffleRecords
+    Inputs: const uint8_t *src, uint8_t *dst, size_t n, int stride
+    Returns: void
+    Purpose: Transpose whole records so byte k of every record is contiguous (and back). Bytes past the
+             last whole record are copied unchanged.
+*/
+void shuffleRecords(const uint8_t *src, uint8_t *dst, size_t n, int stride)
+{
+    size_t count = n / stride;
+    for (size_t r = 0; r < count; ++r)
+        for (int b = 0; b < stride; ++b) dst[b * count + r] = src[r * stride + b];
+    memcpy(dst + count * stride, src + count * stride, n - count * stride);
+}
+
+void unshuffleRecords(const uint8_t *src, uint8_t *dst, size_t n, int stride)
+{
+    size_t count = n / stride;
+    for (size_t r = 0; r < count; ++r)
+        for (int b = 0; b < stride; ++b) dst[r * stride + b] = src[b * count + r];
+    memcpy(dst + count * stride, src + count * stride, n - count * stride);
+}
 
+/*
+    Function: encodeFrame
+    Inputs: const vector<uint8_t> &raw, vector<uint8_t> &frame, int level, int stride (0 = no shuffle)
+    Returns: void
+    Purpose: Build one complete frame; falls back to storing when compression does not pay.
+*/
+void encodeFrame(const vector<uint8_t> &raw, vector<uint8_t> &frame, int level, int stride)
+{
+    vector<uint8_t> shuffled, packed;
+    FrameHeader h;
+    memcpy(h.magic, "MMF1", 4);
+    h.rawLen = (uint32_t)raw.size();
+    h.checksum = frameChecksum(raw.data(), raw.size());
+    h.codec = CODEC_STORE; h.level = (uint8_t)level; h.stride = (uint8_t)stride; h.reserved = 0;
+    const uint8_t *input = raw.data();
+    if (level > 0 && raw.size() >= (size_t)LZ_MIN_MATCH) {
+        if (stride > 1) {
+            shuffled.resize(raw.size());
+            shuffleRecords(raw.data(), shuffled.data(), raw.size(), stride);
+            input = shuffled.data();
+        }
+        lzCompress(input, raw.size(), packed, level);
+        if (packed.size() < raw.size()) h.codec = stride > 1 ? CODEC_SHUFFLE_LZ : CODEC_LZ;
+    }
+    const uint8_t *payload = h.codec == CODEC_STORE ? raw.data() : packed.data();
+    h.payloadLen = h.codec == CODEC_STORE ? h.rawLen : (uint32_t)packed.size();
+    frame.resize(sizeof(h) + h.payloadLen);
+    memcpy(frame.data(), &h, sizeof(h));
+    memcpy(frame.data() + sizeof(h), payload, h.payloadLen);
+}
 
-        // Player 2 Status (Right)
-        LCD.WriteAt((p2.pkmn.name + " (P2)").c_str(), 170, STATUS_TEXT_Y);
-        LCD.WriteAt(("HP: " + to_string(p2.pkmn.hp) + "/" + to_string(p2.pkmn.maxHP)).c_str(), 170, STATUS_TEXT_Y + 14);
+/*
+    Class: CompressedWriter
+    Methods:
+      - open(path, level, stride, threads, resume) : start the writer and the compression pool; with resume,
+                                                     frames are appended after the ones already in the file
+      - append(data, len) : buffer bytes; waits only when COMPRESS_QUEUE_DEPTH chunks are already queued
+      - close() : flush the last chunk, drain the pool, close the file; false on any write error
+      - rawBytes / framedBytes : bytes in and bytes on disk
+*/
+class CompressedWriter {
+public:
+    uint64_t rawBytes, framedBytes;
 
+    CompressedWriter(): rawBytes(0), framedBytes(0), level(0), stride(0), nextSeq(0), nextToWrite(0), stopping(false) {}
 
-        if (p1.pkmn.defending) LCD.WriteAt("[Defending]", 8, STATUS_TEXT_Y + 28);
-        if (p2.pkmn.defending) LCD.WriteAt("[Defending]", 170, STATUS_TEXT_Y + 28);
-        LCD.Update();
+    bool open(const char* path, int lvl, int recordStride, int threads, bool resume = false)
+    {
+        if (!out.open(path, resume)) return false;
+        level = lvl; stride = recordStride;
+        cur.reserve(CHUNK_BYTES);
+        for (int t = 0; t < max(1, threads); ++t) pool.push_back(std::thread(&CompressedWriter::compressMain, this));
+        return true;
     }
 
-
-    /*
-        Function: runMatch
-        Inputs: none
-        Returns: bool (true = player chose to replay immediately)
-        Purpose: Runs one full match (turn loop) including animated projectile attacks,
-                 uses button UI, handles collisions, and returns whether to automatically replay.
-        Author: Aadit Bhatia
-        Resources: Learned the use of vectors from W3Schools
-    */
-    
-    bool runMatch()
+    void append(const void *data, size_t len)
     {
-        // Tracking: current turn (true -> p1)
-        bool p1Turn = true;
+        const uint8_t *src = static_cast<const uint8_t*>(data);
+        rawBytes += len;
+        while (len > 0) {
+            size_t n = min(len, CHUNK_BYTES - cur.size());
+            cur.insert(cur.end(), src, src + n);
+            src += n; len -= n;
+            if (cur.size() == CHUNK_BYTES) pushChunk();
+        }
+    }
 
+    bool close()
+    {
+        if (!cur.empty()) pushChunk();
+        { std::lock_guard<std::mutex> lock(mu); stopping = true; }
+        notEmpty.notify_all();
+        for (auto &t : pool) t.join();
+        return out.close();
+    }
 
-        // Reset defend states
-        p1.pkmn.defending = false; p2.pkmn.defending = false;
+    const char* backendName() const { return out.backendName(); }
 
+private:
+    struct Chunk { uint64_t seq; vector<uint8_t> data; };
 
-        // Battle loop(while both alive)
-        while (!p1.pkmn.fainted() && !p2.pkmn.fainted())
-        {
-            // draw scene: background, status, then pokemon so pokemon render on top of status area
-            drawBackground();
-            drawBattleStatus(p1, p2);
-            drawPokemonGraphic(p1.pkmn, false);
-            drawPokemonGraphic(p2.pkmn, true);
+    AsyncWriter out;
+    int level, stride;
+    vector<uint8_t> cur;
+    uint64_t nextSeq, nextToWrite;
+    std::mutex mu, writeMu;
+    std::condition_variable notFull, notEmpty;
+    deque<Chunk> queue;
+    map<uint64_t, vector<uint8_t>> finished; // frames compressed ahead of their turn
+    bool stopping;
+    vector<std::thread> pool;
 
+    void pushChunk()
+    {
+        std::unique_lock<std::mutex> lock(mu);
+        notFull.wait(lock, [this] { return queue.size() < (size_t)COMPRESS_QUEUE_DEPTH; });
+        queue.push_back(Chunk());
+        queue.back().seq = nextSeq++;
+        queue.back().data.swap(cur);
+        lock.unlock();
+        notEmpty.notify_one();
+        cur.reserve(CHUNK_BYTES);
+    }
 
-            // draw 4 battle buttons (2x2 grid)
-            Player *actor = p1Turn ? &p1 : &p2;
-            Player *target = p1Turn ? &p2 : &p1;
+    void compressMain()
+    {
+        vector<uint8_t> frame;
+        while (true) {
+            Chunk c;
+            {
+                std::unique_lock<std::mutex> lock(mu);
+                notEmpty.wait(lock, [this] { return stopping || !queue.empty(); });
+                if (queue.empty()) return; // stopping and drained
+                c.seq = queue.front().seq;
+                c.data.swap(queue.front().data);
+                queue.pop_front();
+            }
+            notFull.notify_one();
+            encodeFrame(c.data, frame, level, stride);
 
+            // write frames in chunk order: whoever completes the next one drains everything ready
+            std::lock_guard<std::mutex> lock(writeMu);
+            finished[c.seq].swap(frame);
+            for (auto it = finished.find(nextToWrite); it != finished.end(); it = finished.find(nextToWrite)) {
+                out.append(it->second.data(), it->second.size());
+                framedBytes += it->second.size();
+                finished.erase(it);
+                nextToWrite++;
+            }
+        }
+    }
+};
 
-            // Build button rectangles and labels
-            struct Btn
-            {
-                int x,y,w,h; string label; int id;
-            };
-            vector<Btn> btns;
-           
-            // Helper lambda to calculate Y position for row (0 or 1)
-            auto getY = [](int row) { return BBTN_START_Y + row * (BBTN_H + BBTN_GAP); };
+/*
+    Class: FramedReader
+    Methods:
+      - open(path) / close()
+      - next(raw) : decode the next frame into raw; false if the next frame is not complete (yet) or is damaged
+      - offset : file position of the next frame
+    Purpose: Read a framed file, including one that is still being written; call next() again later to follow it.
+*/
+struct FramedReader {
+    int fd = -1;
+    uint64_t offset = 0;
 
+    bool open(const char* path) { fd = ::open(path, O_RDONLY); offset = 0; return fd >= 0; }
+    void close() { if (fd >= 0) ::close(fd); fd = -1; }
 
-            // Button 0 (Top Left) - Move 1
-            btns.push_back({BBTN_LEFT_X, getY(0), BBTN_W, BBTN_H, actor->pkmn.moves[0].name + " (" + to_string(actor->pkmn.moves[0].pp) + ")", 0});
-           
-            // Button 1 (Top Right) - Move 2
-            btns.push_back({BBTN_RIGHT_X, getY(0), BBTN_W, BBTN_H, actor->pkmn.moves[1].name + " (" + to_string(actor->pkmn.moves[1].pp) + ")", 1});
-           
-            // Button 2 (Bottom Left) - Move 3
-            btns.push_back({BBTN_LEFT_X, getY(1), BBTN_W, BBTN_H, actor->pkmn.moves[2].name + " (" + to_string(actor->pkmn.moves[2].pp) + ")", 2});
+    bool next(vector<uint8_t> &raw)
+    {
+        FrameHeader h;
+        if (pread(fd, &h, sizeof(h), (off_t)offset) != (ssize_t)sizeof(h) || memcmp(h.magic, "MMF1", 4) != 0) return false;
+        vector<uint8_t> payload(h.payloadLen);
+        if (pread(fd, payload.data(), h.payloadLen, (off_t)(offset + sizeof(h))) != (ssize_t)h.payloadLen) return false;
+        raw.resize(h.rawLen);
+        if (h.codec == CODEC_STORE) {
+            if (h.payloadLen != h.rawLen) return false;
+            memcpy(raw.data(), payload.data(), h.rawLen);
+        } else {
+            vector<uint8_t> shuffled(h.codec == CODEC_SHUFFLE_LZ ? h.rawLen : 0);
+            uint8_t *dst = h.codec == CODEC_SHUFFLE_LZ ? shuffled.data() : raw.data();
+            if (!lzDecompress(payload.data(), h.payloadLen, dst, h.rawLen)) return false;
+            if (h.codec == CODEC_SHUFFLE_LZ) unshuffleRecords(shuffled.data(), raw.data(), h.rawLen, h.stride);
+        }
+        if (frameChecksum(raw.data(), raw.size()) != h.checksum) return false;
+        offset += sizeof(h) + h.payloadLen;
+        return true;
+    }
+};
 
+// ----------------------------- MULTI-PROCESS SIMULATOR -----------------------------
+// The parent forks SIM_MAX_WORKERS-capped worker processes that each play CPU-vs-CPU matches with
+// FastBattle. Every worker owns one single-producer/single-consumer ring of fixed-size MatchResult
+// records in a shared anonymous mapping made before fork(). The parent aggregates records in place
+// straight from the rings: no serialization, no pipes and no syscalls per record. Indices are
+// free-running 64-bit counters on separate cache lines; the producer publishes its head every
+// SIM_PUBLISH_BATCH records and the consumer retires a whole batch with one tail store.
+// Every match is seeded from (worker, match number), so a worker can start at any match. The valid
+// frames of the results file are the progress record: a run that was killed is resumed by reading
+// them back, counting what each worker finished, and appending only the rest.
+// On Linux the workers are dealt round-robin over the NUMA nodes (/sys/devices/system/node) and each
+// is pinned to one CPU of its node. A worker writes every page of its own ring before the parent reads
+// any of it; pages are placed on the node that touches them first, so the ring sits next to its
+// producer instead of next to the parent. The report shows matches per node and the speedup over a
+// single-core baseline measured before the fork.
+const int SIM_MAX_WORKERS = 64;
+const long SIM_MATCHES_PER_WORKER = 200000;
+const int SIM_RING_SIZE = 4096;     // records per worker ring; power of two
+const int SIM_PUBLISH_BATCH = 64;   // power of two, divides SIM_RING_SIZE
+const int SIM_MAX_TURNS = 200;
+const char* SIM_RESULTS_FILE = "sim_results.mmf"; // framed, compressed MatchResult records in aggregation order
+const int SIM_COMPRESS_THREADS = 2;
+const int SIM_MAX_NODES = 64;
+const long SIM_BASELINE_MATCHES = 20000; // single-core matches timed for the scaling report
 
-            // Button 3 (Bottom Right) - Run
-            btns.push_back({BBTN_RIGHT_X, getY(1), BBTN_W, BBTN_H, "RUN", 3});
+/*
+    Class: MatchResult
+    Members:
+      - uint16_t speciesA, speciesB : bank indices (A moves first)
+      - uint8_t winner : 0 = A, 1 = B, 2 = someone retreated, 3 = turn limit
+      - uint8_t difficulty
+      - uint16_t turns, hpLeft : match length and the winner's remaining HP
+      - uint16_t worker, uint32_t match : who played it and its number within that worker
+    Purpose: One finished match, 16 bytes, written once by a worker and read in place by the aggregator.
+*/
+struct MatchResult {
+    uint16_t speciesA, speciesB;
+    uint8_t winner, difficulty;
+    uint16_t turns, hpLeft;
+    uint16_t worker;
+    uint32_t match;
+};
+static_assert(sizeof(MatchResult) == 16, "MatchResult is a fixed 16-byte record");
 
+/*
+    Class: SimRing
+    Members:
+      - atomic<uint64_t> head : records published by the worker
+      - atomic<uint64_t> tail : records consumed by the aggregator
+      - atomic<int> done : worker finished (head is final)
+      - MatchResult slots[SIM_RING_SIZE]
+    Purpose: Page-aligned, so no page is shared by two workers' rings.
+*/
+struct alignas(4096) SimRing {
+    alignas(64) std::atomic<uint64_t> head;
+    alignas(64) std::atomic<uint64_t> tail;
+    alignas(64) std::atomic<int> done;
+    alignas(64) MatchResult slots[SIM_RING_SIZE];
+};
 
+double simClockSec()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
 
+/*
+    Class: SimTally
+    Members:
+      - int n : bank size
+      - vector<uint64_t> wins (n x n, A-beats-B), games, won : per-species counts
+      - uint64_t total, turns, retreats
+    Methods:
+      - add(m) : count one finished match
+*/
+struct SimTally {
+    int n;
+    vector<uint64_t> wins, games, won;
+    uint64_t total, turns, retreats;
 
-            // Draw buttons
-            // &b is a reference to the button, btns is the whole vector of buttons, so we loop through each button to draw it
-            for (auto &b : btns) {
-                LCD.SetFontColor(WHITE);
-                LCD.DrawRectangle(b.x, b.y, b.w, b.h);
-                LCD.WriteAt(b.label.c_str(), b.x + 6, b.y + 12);
-            }
-            LCD.Update();
+    explicit SimTally(int species): n(species), wins(species * species, 0), games(species, 0), won(species, 0),
+                                    total(0), turns(0), retreats(0) {}
 
+    void add(const MatchResult &m)
+    {
+        games[m.speciesA]++; games[m.speciesB]++;
+        turns += m.turns;
+        if (m.winner < 2) {
+            int winner = m.winner == 0 ? m.speciesA : m.speciesB, loser = m.winner == 0 ? m.speciesB : m.speciesA;
+            wins[winner * n + loser]++;
+            won[winner]++;
+        } else if (m.winner == 2) retreats++;
+        total++;
+    }
+};
 
-            // If actor is human, wait for button press; for CPU, decide action and animate small pause
-            int chosen = -1;
-            if (actor->isHuman) {
-                // wait for clean press and map to button hitboxes
-                int tx, ty;
-                WaitForCleanPress(tx, ty);
+/*
+    Function: simResume
+    Inputs: int workers, long matchesPerWorker, vector<long> &done (out), SimTally &tally (out)
+    Returns: bool (true if the results file holds an unfinished run of this shape to continue)
+    Purpose: Read back the valid frames of SIM_RESULTS_FILE, count each worker's finished matches and
+             re-tally them, then cut the file after the last valid frame (a torn or out-of-order tail
+             from a killed run is dropped and replayed). Anything that does not fit (another worker
+             count, gaps in a worker's match numbers, a finished run) means starting over.
+*/
+bool simResume(int workers, long matchesPerWorker, vector<long> &done, SimTally &tally)
+{
+    FramedReader reader;
+    if (!reader.open(SIM_RESULTS_FILE)) return false;
+    vector<uint8_t> raw;
+    bool fits = true;
+    while (fits && reader.next(raw)) {
+        for (size_t off = 0; off + sizeof(MatchResult) <= raw.size(); off += sizeof(MatchResult)) {
+            MatchResult m;
+            memcpy(&m, raw.data() + off, sizeof(m));
+            if (m.worker >= workers || (long)m.match != done[m.worker] || m.speciesA >= tally.n || m.speciesB >= tally.n) {
+                fits = false;
+                break;
+            }
+            done[m.worker]++;
+            tally.add(m);
+        }
+    }
+    uint64_t valid = reader.offset;
+    reader.close();
+    bool finished = tally.total == (uint64_t)workers * matchesPerWorker;
+    if (!fits || finished || tally.total == 0 || truncate(SIM_RESULTS_FILE, (off_t)valid) != 0) {
+        std::fill(done.begin(), done.end(), 0);
+        tally = SimTally(tally.n);
+        return false;
+    }
+    return true;
+}
 
+/*
+    Function: simPlayMatch
+    Inputs: Game &game, FastBattle &fb, uint32_t worker, uint32_t match
+    Returns: MatchResult
+    Purpose: One CPU-vs-CPU match on FastBattle with random species and difficulty, seeded from
+             (worker, match) so it plays the same whether or not the run was resumed.
+*/
+MatchResult simPlayMatch(Game &game, FastBattle &fb, uint32_t worker, uint32_t match)
+{
+    fb.rng.seed(0x9E3779B9u * (worker + 1) ^ match * 0x85EBCA6Bu);
+    int n = (int)game.bank.size();
+    int a = fb.rng.range(0, n - 1), b = fb.rng.range(0, n - 1);
+    while (b == a) b = fb.rng.range(0, n - 1);
+    game.difficulty = fb.rng.range(0, 1);
+    fb.init(game, game.bank[a], game.bank[b]);
+    MatchResult r = {(uint16_t)a, (uint16_t)b, 3, (uint8_t)game.difficulty, 0, 0, (uint16_t)worker, match};
+    for (int t = 0; t < SIM_MAX_TURNS; ++t) {
+        int side = t % 2;
+        r.turns = (uint16_t)(t + 1);
+        if (fb.act(side, fb.cpuChoose(side)).outcome == Game::ACT_RETREAT) { r.winner = 2; break; }
+        if (fb.hp[1 - side] <= 0) { r.winner = (uint8_t)side; r.hpLeft = (uint16_t)fb.hp[side]; break; }
+    }
+    return r;
+}
 
-                // find which button was pressed
-                //same loop logic as drawing buttons, but now checking if touch coords are within button bounds
-                bool found = false;
-                for (auto &b : btns) {
-                    if (tx >= b.x && tx <= b.x + b.w && ty >= b.y && ty <= b.y + b.h) {
-                        chosen = b.id;
-                        // highlight visual
-                        LCD.SetFontColor(BLACK); LCD.FillRectangle(b.x, b.y, b.w, b.h);
-                        LCD.SetFontColor(YELLOW); LCD.WriteAt(b.label.c_str(), b.x + 6, b.y + 12);
-                        LCD.Update();
-                        SleepMs(160);
-                        found = true;
-                        break;
-                    }
-                }
-                if (!found) {
-                    // Nothing valid pressed; skip to next iteration
-                    continue;
-                }
-            } else {
-                // CPU decision based on difficulty
-                SleepMs(400);
-                int r = randInt(1,100);
-                if (difficulty == 0) { // Easy: more random
-                    if (r <= 35) chosen = 0;
-                    else if (r <= 70) chosen = 1;
-                    else if (r <= 85) chosen = 2; // move 3 (utility)
-                    else chosen = 3; // run occasionally
-                } else { // Hard: prefer strongest move and attacks
-                    int best = 0;
-                    for (int i=0;i<(int)actor->pkmn.moves.size();++i) if (actor->pkmn.moves[i].power > actor->pkmn.moves[best].power && actor->pkmn.moves[i].pp>0) best=i;
-                    chosen = (randInt(1,100) <= 85) ? best : 3;
-                }
-                // Highlight CPU chosen button
-                if (chosen != -1) {
-                    Btn b = btns[chosen];
-                    LCD.SetFontColor(BLACK); LCD.FillRectangle(b.x, b.y, b.w, b.h);
-                    LCD.SetFontColor(YELLOW); LCD.WriteAt(b.label.c_str(), b.x + 6, b.y + 12);
-                    LCD.Update();
-                    SleepMs(300);
-                }
+/*
+    Function: simNodeCpus
+    Inputs: none
+    Returns: vector<vector<int>> - the CPUs this process may run on, grouped by NUMA node (empty nodes dropped)
+    Purpose: Read each node's cpulist ("0-3,8-11") from sysfs. Without NUMA information every allowed CPU
+             is put in one node.
+*/
+vector<vector<int>> simNodeCpus()
+{
+    vector<vector<int>> nodes;
+#ifdef __linux__
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return nodes;
+    vector<int> all;
+    for (int c = 0; c < CPU_SETSIZE; ++c) if (CPU_ISSET(c, &allowed)) all.push_back(c);
+    for (int node = 0; node < SIM_MAX_NODES; ++node) {
+        char path[64];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        FILE *f = fopen(path, "r");
+        if (!f) continue; // node numbers can have gaps
+        vector<int> cpus;
+        int lo, hi;
+        char sep;
+        while (fscanf(f, "%d", &lo) == 1) {
+            hi = lo;
+            sep = '\n';
+            if (fscanf(f, "%c", &sep) == 1 && sep == '-') {
+                if (fscanf(f, "%d", &hi) != 1) break;
+                if (fscanf(f, "%c", &sep) != 1) sep = '\n';
             }
+            for (int c = lo; c <= hi && c < CPU_SETSIZE; ++c) if (c >= 0 && CPU_ISSET(c, &allowed)) cpus.push_back(c);
+            if (sep != ',') break;
+        }
+        fclose(f);
+        if (!cpus.empty()) nodes.push_back(cpus);
+    }
+    if (nodes.empty() && !all.empty()) nodes.push_back(all);
+#endif
+    return nodes;
+}
 
+/*
+    Function: simPinAndTouch
+    Inputs: SimRing &ring, int cpu (-1 = leave unpinned)
+    Returns: void (runs in the forked child, before the parent reads the ring)
+    Purpose: Pin the worker to its CPU, then initialise and write every page of its ring so the pages
+             are allocated on the worker's node.
+*/
+void simPinAndTouch(SimRing &ring, int cpu)
+{
+#ifdef __linux__
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        sched_setaffinity(0, sizeof(set), &set);
+    }
+#else
+    (void)cpu;
+#endif
+    new (&ring.head) std::atomic<uint64_t>(0);
+    new (&ring.tail) std::atomic<uint64_t>(0);
+    new (&ring.done) std::atomic<int>(0);
+    memset(ring.slots, 0, sizeof(ring.slots));
+}
 
-            // Process chosen action
-            if (chosen == 3) { // Run
-                // retreat: heal a bit and end match (counts as immediate exit)
-                actor->pkmn.hp += RETREAT_HEAL;
-                if (actor->pkmn.hp > actor->pkmn.maxHP) actor->pkmn.hp = actor->pkmn.maxHP;
-                LCD.Clear(BLACK); LCD.WriteLine((actor->pkmn.name + " retreated and healed.").c_str());
-                SleepMs(800);
-                // treat retreat as match over and go to menu (no play again)
-                return false;
-            } else if (chosen != -1) {
-                // Attack using move index = chosen (0..2)
-                int mIdx = chosen;
-                if (mIdx >= (int)actor->pkmn.moves.size()) mIdx = 0;
-                Move &mv = actor->pkmn.moves[mIdx];
-               
-                // If move power is 0, treat as utility/defend
-                if (mv.power == 0) {
-                    if (mv.pp <= 0) {
-                        LCD.Clear(BLACK); LCD.WriteLine("No PP left for that move."); SleepMs(700);
-                    } else {
-                        // Assume utility move is defend/boost for simplicity
-                        actor->pkmn.defending = true;
-                        mv.pp--;
-                        LCD.Clear(BLACK); LCD.WriteLine((actor->pkmn.name + " used " + mv.name + "! Defending...").c_str());
-                        SleepMs(900);
-                    }
-                } else { // Standard attack move (power > 0)
-                    if (mv.pp <= 0) {
-                        LCD.Clear(BLACK); LCD.WriteLine("No PP left for that move."); SleepMs(700);
-                    } else {
-                        // Animate projectile from actor to target and detect collision with bounding box
-                        // projectile represented as small filled rectangle that moves across
-                        int projX = actor->pkmn.x + (actor == &p1 ? actor->pkmn.w : -8);
-                        int projY = actor->pkmn.y + actor->pkmn.h/2;
-                        int dir = (actor == &p1) ? 1 : -1;
-                        bool hit = false;
-
-
-                        int roll = randInt(1,100);
-                        if (roll > mv.accuracy) {
-                            // miss: show message and continue
-                            LCD.Clear(BLACK);
-                            LCD.WriteLine((actor->pkmn.name + " used " + mv.name + " but missed!").c_str());
-                            SleepMs(900);
-                        } else {
-                            // spawn projectile and animate
-                            while (projX > 0 && projX < SCREEN_W) {
-                                // Redraw only the dynamic elements (background, status, sprites, projectile)
-                                drawBackground();
-                                drawBattleStatus(p1, p2); // Ensure status updates (drawn beneath sprites)
-                                drawPokemonGraphic(p1.pkmn,false);
-                                drawPokemonGraphic(p2.pkmn,true);
-
-
-                                // draw projectile
-                                LCD.SetFontColor(YELLOW);
-                                LCD.FillRectangle(projX, projY - 4, 8, 8);
-
-
-                                // redraw buttons (so user sees them)
-                                for (auto &b : btns) { LCD.SetFontColor(WHITE); LCD.DrawRectangle(b.x, b.y, b.w, b.h); LCD.WriteAt(b.label.c_str(), b.x + 6, b.y + 12); }
-                                // Re-highlight the chosen button during animation
-                                if (chosen != -1) {
-                                    Btn b = btns[chosen];
-                                    LCD.SetFontColor(BLACK); LCD.FillRectangle(b.x, b.y, b.w, b.h);
-                                    LCD.SetFontColor(YELLOW); LCD.WriteAt(b.label.c_str(), b.x + 6, b.y + 12);
-                                }
-
-
-                                LCD.Update();
-
-
-                                // check collision with target bounding box
-                                int tx1 = target->pkmn.x, ty1 = target->pkmn.y, tw = target->pkmn.w, th = target->pkmn.h;
-                                int px1 = projX, py1 = projY - 4, pw = 8, ph = 8;
-                                bool overlap = !(px1 + pw < tx1 || px1 > tx1 + tw || py1 + ph < ty1 || py1 > ty1 + th);
-                                if (overlap) { hit = true; break; }
-
-
-                                // step projectile
-                                projX += dir * PROJECTILE_STEP_PX;
-                                SleepMs(PROJECTILE_SPEED_MS);
-                            } // end projectile animate
-
-
-                            // If hit, apply damage
-                            if (hit) {
-                                // apply damage formula
-                                int dmg = computeDamage(actor->pkmn, target->pkmn, mv);
-                                if (target->pkmn.defending) {
-                                    dmg = (dmg + 1)/2;
-                                    target->pkmn.defending = false;
-                                }
-                                target->pkmn.hp -= dmg; if (target->pkmn.hp < 0) target->pkmn.hp = 0;
-                                mv.pp--;
-                                // show result
-                                LCD.Clear(BLACK);
-                                LCD.WriteLine((actor->pkmn.name + " used " + mv.name + "!").c_str());
-                                LCD.WriteLine(("Hit for " + to_string(dmg) + " dmg").c_str());
-                                SleepMs(900);
-                            } else {
-                                // projectile flew off screen - treat as miss (shouldn't happen with animation logic)
-                                LCD.Clear(BLACK);
-                                LCD.WriteLine((actor->pkmn.name + " used " + mv.name + " - no hit.").c_str());
-                                mv.pp--;
-                                SleepMs(700);
-                            }
-                        } // end accuracy branch
-                    } // end else have PP
-                } // end power > 0 (attack)
-               
-                // If the actor attacked, clear their defend state for next turn. Target state is cleared on hit.
-                if (actor->pkmn.defending && mv.power > 0) actor->pkmn.defending = false;
-
-
-            } // end chosen != -1
-           
-            // small pause, then swap turns
-            SleepMs(200);
-            p1Turn = !p1Turn;
-        } // end while battle
+/*
+    Function: simWorker
+    Inputs: Game &game, SimRing &ring, uint32_t worker, long first, long matches
+    Returns: void (runs in the forked child)
+    Purpose: Produce results for matches first..matches-1 into the worker's ring, waiting only when the ring is full.
+*/
+void simWorker(Game &game, SimRing &ring, uint32_t worker, long first, long matches)
+{
+    FastBattle fb;
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    uint64_t tailSeen = ring.tail.load(std::memory_order_acquire);
+    for (long m = first; m < matches; ++m) {
+        while (head - tailSeen == (uint64_t)SIM_RING_SIZE) {
+            ring.head.store(head, std::memory_order_release); // make sure the consumer sees everything before waiting
+            sched_yield();
+            tailSeen = ring.tail.load(std::memory_order_acquire);
+        }
+        ring.slots[head & (SIM_RING_SIZE - 1)] = simPlayMatch(game, fb, worker, (uint32_t)m);
+        ++head;
+        if ((head & (SIM_PUBLISH_BATCH - 1)) == 0) ring.head.store(head, std::memory_order_release);
+    }
+    ring.head.store(head, std::memory_order_release);
+    ring.done.store(1, std::memory_order_release);
+}
 
+/*
+    Function: runSimulator
+    Inputs: Game &game, int workers, long matchesPerWorker
+    Returns: int process exit status
+    Purpose: Fork the workers, aggregate every ring until all are done, then print win rates and throughput.
+             An unfinished results file from an earlier run is resumed rather than overwritten.
+*/
+int runSimulator(Game &game, int workers, long matchesPerWorker)
+{
+    workers = max(1, min(workers, SIM_MAX_WORKERS));
+    size_t bytes = sizeof(SimRing) * workers;
+    void *mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) { perror("mmap"); return 1; }
+    SimRing *rings = static_cast<SimRing*>(mem); // each worker initialises its own ring (simPinAndTouch)
 
-        // End of battle - display result
-        LCD.Clear(BLACK);
-        if (p1.pkmn.fainted() && p2.pkmn.fainted()) {
-            LCD.WriteLine("It's a tie!");
-        } else if (p1.pkmn.fainted()) {
-            LCD.WriteLine((p1.label + " lost. " + p2.label + " wins!").c_str());
-            if (p2.isHuman) humanWins++; else cpuWins++;
-        } else if (p2.pkmn.fainted()) {
-            LCD.WriteLine((p2.label + " lost. " + p1.label + " wins!").c_str());
-            if (p1.isHuman) humanWins++; else cpuWins++;
-        } else {
-            LCD.WriteLine("Match ended unexpectedly.");
+    // worker w runs on node w % nodes, on that node's CPUs in turn
+    vector<vector<int>> nodes = simNodeCpus();
+    int numNodes = max(1, (int)nodes.size());
+    vector<int> workerCpu(workers, -1), workerNode(workers, 0);
+    for (int w = 0; w < workers; ++w) {
+        workerNode[w] = w % numNodes;
+        if (!nodes.empty()) {
+            const vector<int> &cpus = nodes[workerNode[w]];
+            workerCpu[w] = cpus[(w / numNodes) % cpus.size()];
         }
-        gamesPlayed++;
-        SleepMs(RESULT_PAUSE_MS);
+    }
 
+    int n = (int)game.bank.size();
+    SimTally tally(n);
+    vector<long> done(workers, 0);
+    bool resumed = simResume(workers, matchesPerWorker, done, tally);
+    if (resumed) printf("resuming %s: %llu of %llu matches already done\n", SIM_RESULTS_FILE,
+                        (unsigned long long)tally.total, (unsigned long long)workers * matchesPerWorker);
+    uint64_t resumedTotal = tally.total;
 
-        // Ask for replay
-        LCD.WriteLine("");
-        LCD.WriteLine("Play again? Tap TOP half = YES, bottom half = NO");
-        int rx, ry;
-        WaitForCleanPress(rx, ry);
-        bool again = (ry < SCREEN_H/2);
-        SleepMs(400);
-        return again;
-    } // end runMatch
+    // single-core baseline for the speedup figure, played in the parent on matches no worker plays
+    FastBattle baseline;
+    double baseStart = simClockSec();
+    for (long m = 0; m < SIM_BASELINE_MATCHES; ++m) simPlayMatch(game, baseline, SIM_MAX_WORKERS, (uint32_t)m);
+    double baseRate = SIM_BASELINE_MATCHES / (simClockSec() - baseStart);
 
+    double start = simClockSec();
+    vector<pid_t> pids;
+    int ready[2]; // each worker writes one byte once its ring is touched
+    if (pipe(ready) != 0) { perror("pipe"); munmap(mem, bytes); return 1; }
+    for (int w = 0; w < workers; ++w) {
+        pid_t pid = fork();
+        if (pid < 0) { perror("fork"); break; }
+        if (pid == 0) {
+            simPinAndTouch(rings[w], workerCpu[w]);
+            if (write(ready[1], "r", 1) != 1) _exit(1);
+            ::close(ready[0]); ::close(ready[1]);
+            simWorker(game, rings[w], (uint32_t)w, done[w], matchesPerWorker);
+            _exit(0);
+        }
+        pids.push_back(pid);
+    }
+    // wait until every ring is placed (EOF instead if a worker died first) before touching any of them
+    ::close(ready[1]);
+    char byte;
+    for (size_t got = 0; got < pids.size() && read(ready[0], &byte, 1) == 1; ++got) {}
+    ::close(ready[0]);
 
-}; // end class Game
+    // the writer starts compression threads and (io_uring) a kernel ring, so it is opened only after
+    // every fork: a child must not inherit either
+    CompressedWriter out;
+    if (!out.open(SIM_RESULTS_FILE, MINIMON_COMPRESS_LEVEL, sizeof(MatchResult), SIM_COMPRESS_THREADS, resumed)) {
+        perror(SIM_RESULTS_FILE);
+        for (pid_t pid : pids) { kill(pid, SIGKILL); waitpid(pid, nullptr, 0); }
+        munmap(mem, bytes);
+        return 1;
+    }
+
+    // aggregate in place: tally.wins[a * n + b] counts A-beats-B, so win rates come straight out of the matrix
+    uint64_t busyPolls = 0;
+    double busySec = 0;
+    // A worker that dies never sets `done`, so idle rings also check whether their worker was reaped;
+    // its ring is still drained, and the shortfall makes the run fail (the file stays resumable).
+    vector<bool> reaped(pids.size(), false);
+    vector<uint64_t> nodeMatches(numNodes, 0);
+    int died = 0;
+    int running = (int)pids.size();
+    while (running > 0) {
+        running = 0;
+        bool any = false;
+        for (int w = 0; w < (int)pids.size(); ++w) {
+            SimRing &r = rings[w];
+            int status = 0;
+            if (!reaped[w] && !r.done.load(std::memory_order_acquire) &&
+                r.tail.load(std::memory_order_relaxed) == r.head.load(std::memory_order_acquire) &&
+                waitpid(pids[w], &status, WNOHANG) == pids[w]) {
+                reaped[w] = true;
+                if (!r.done.load(std::memory_order_acquire)) {
+                    died++;
+                    if (WIFSIGNALED(status)) printf("worker %d killed by signal %d\n", w, WTERMSIG(status));
+                    else printf("worker %d exited with status %d before finishing\n", w, WEXITSTATUS(status));
+                }
+            }
+            bool done = reaped[w] || r.done.load(std::memory_order_acquire);
+            uint64_t tail = r.tail.load(std::memory_order_relaxed);
+            uint64_t head = r.head.load(std::memory_order_acquire);
+            if (!done || tail != head) running++;
+            if (tail == head) continue;
+            any = true;
+            double t0 = simClockSec();
+            // hand the batch to the writer straight from the ring (at most two pieces if it wraps)
+            uint64_t first = tail & (SIM_RING_SIZE - 1), count = head - tail;
+            uint64_t firstRun = min(count, (uint64_t)SIM_RING_SIZE - first);
+            out.append(&r.slots[first], firstRun * sizeof(MatchResult));
+            if (count > firstRun) out.append(&r.slots[0], (count - firstRun) * sizeof(MatchResult));
+            for (; tail != head; ++tail) tally.add(r.slots[tail & (SIM_RING_SIZE - 1)]);
+            nodeMatches[workerNode[w]] += count;
+            r.tail.store(tail, std::memory_order_release);
+            busySec += simClockSec() - t0;
+            busyPolls++;
+        }
+        if (!any) sched_yield();
+    }
+    for (int w = 0; w < (int)pids.size(); ++w) if (!reaped[w]) waitpid(pids[w], nullptr, 0);
+    bool written = out.close();
+    double secs = simClockSec() - start;
+
+    uint64_t played = tally.total - resumedTotal;
+    printf("simulated %llu matches with %d workers in %.2f s: %.0f results/s\n", (unsigned long long)played,
+           (int)pids.size(), secs, played / secs);
+    printf("scaling: single core %.0f results/s, %d workers %.2fx (%.0f%% per worker)\n", baseRate,
+           (int)pids.size(), played / secs / baseRate, pids.empty() ? 0.0 : 100.0 * played / secs / baseRate / pids.size());
+    for (int node = 0; node < numNodes; ++node) {
+        int onNode = 0;
+        for (int w = 0; w < (int)pids.size(); ++w) onNode += workerNode[w] == node;
+        printf("  node %d: %d CPUs, %d workers, %llu matches\n", node, nodes.empty() ? 0 : (int)nodes[node].size(),
+               onNode, (unsigned long long)nodeMatches[node]);
+    }
+    printf("aggregator: %.0f results/s while busy (%llu batches), avg %.1f turns, %llu retreats\n",
+           busySec > 0 ? played / busySec : 0.0, (unsigned long long)busyPolls,
+           tally.total ? (double)tally.turns / tally.total : 0.0, (unsigned long long)tally.retreats);
+    printf("results file: %s, %.1f MB -> %.1f MB (%.1fx, level %d) via %s%s\n", SIM_RESULTS_FILE, out.rawBytes / 1e6,
+           out.framedBytes / 1e6, out.framedBytes ? (double)out.rawBytes / out.framedBytes : 0.0, MINIMON_COMPRESS_LEVEL,
+           out.backendName(), written ? "" : " (WRITE ERRORS)");
+    // read the file back frame by frame, as a live reader would, and check nothing was lost
+    FramedReader reader;
+    uint64_t readBack = 0, readTurns = 0;
+    vector<uint8_t> raw;
+    if (reader.open(SIM_RESULTS_FILE)) {
+        while (reader.next(raw))
+            for (size_t off = 0; off + sizeof(MatchResult) <= raw.size(); off += sizeof(MatchResult)) {
+                MatchResult m;
+                memcpy(&m, raw.data() + off, sizeof(m));
+                readTurns += m.turns;
+                readBack++;
+            }
+        reader.close();
+    }
+    bool verified = readBack == tally.total && readTurns == tally.turns;
+    printf("read back %llu records: %s\n", (unsigned long long)readBack, verified ? "ok" : "MISMATCH");
+    for (int s = 0; s < n; ++s)
+        printf("  %-12s win rate %5.1f%% over %llu matches\n", game.bank[s].name.c_str(),
+               tally.games[s] ? 100.0 * tally.won[s] / tally.games[s] : 0.0, (unsigned long long)tally.games[s]);
+    munmap(mem, bytes);
+    if (died) printf("%d worker(s) died: rerun to resume the missing matches\n", died);
+    return written && verified && died == 0 && tally.total == (uint64_t)workers * matchesPerWorker ? 0 : 1;
+}
+#endif
 
 // ----------------------------- GLOBAL UI HELPERS (comment blocks) -----------------------------
 /*
@@ -755,13 +5250,13 @@ public:
 */
 void DrawPlaySubmenu(Game &game)
 {
-    LCD.Clear(BLACK);
-    LCD.SetFontColor(WHITE);
-    LCD.WriteAt("Play - Select Difficulty", 24, 10);
-    LCD.DrawRectangle(30, 50, 120, 40); LCD.WriteAt("1. Easy", 40, 62);
-    LCD.DrawRectangle(170, 50, 120, 40); LCD.WriteAt("2. Hard", 180, 62);
-    LCD.DrawRectangle(30, 110, 260, 40); LCD.WriteAt("3. Start Match", 100, 122);
-    LCD.Update();
+    Screen.Clear(BLACK);
+    Screen.SetFontColor(WHITE);
+    Screen.WriteAt("Play - Select Difficulty", 24, 10);
+    Screen.DrawRectangle(30, 50, 120, 40); Screen.WriteAt("1. Easy", 40, 62);
+    Screen.DrawRectangle(170, 50, 120, 40); Screen.WriteAt("2. Hard", 180, 62);
+    Screen.DrawRectangle(30, 110, 260, 40); Screen.WriteAt("3. Start Match", 100, 122);
+    Screen.Update();
 }
 
 /*
@@ -773,8 +5268,9 @@ void DrawPlaySubmenu(Game &game)
 */
 int GetSimpleMenuChoice(int numRegions)
 {
+    WaitIdle idle;
     int x,y;
-    while (!LCD.Touch(&x,&y)) {}
+    while (!PollTouchIdle(x, y)) {}
     int ty = y;
     WaitForTouchRelease();
     int regionH = SCREEN_H / numRegions;
@@ -794,13 +5290,13 @@ int GetSimpleMenuChoice(int numRegions)
 */
 void showInstructions()
 {
-    LCD.Clear(BLACK);
-    LCD.SetFontColor(WHITE);
-    LCD.WriteLine("Instructions:");
-    LCD.WriteLine("- Use the 4 in-battle buttons to select moves.");
-    LCD.WriteLine("- Attack fires a projectile; defend halves next damage.");
-    LCD.WriteLine("- Retreat heals and exits the match.");
-    LCD.WriteLine("- Difficulty affects CPU behavior.");
+    Screen.Clear(BLACK);
+    Screen.SetFontColor(WHITE);
+    Screen.WriteLine("Instructions:");
+    Screen.WriteLine("- Use the 4 in-battle buttons to select moves.");
+    Screen.WriteLine("- Attack fires a projectile; defend halves next damage.");
+    Screen.WriteLine("- Retreat heals and exits the match.");
+    Screen.WriteLine("- Difficulty affects CPU behavior.");
     SleepMs(3000);
 }
 
@@ -814,12 +5310,18 @@ void showInstructions()
 */
 void showStatistics(Game &game)
 {
-    LCD.Clear(BLACK);
-    LCD.SetFontColor(WHITE);
-    LCD.WriteLine("Statistics (session):");
-    LCD.WriteLine(("Games Played: " + to_string(game.gamesPlayed)).c_str());
-    LCD.WriteLine(("Human Wins: " + to_string(game.humanWins)).c_str());
-    LCD.WriteLine(("CPU Wins: " + to_string(game.cpuWins)).c_str());
+    Screen.Clear(BLACK);
+    Screen.SetFontColor(WHITE);
+    Screen.WriteLine("Statistics (session):");
+    Screen.WriteLine(("Games Played: " + to_string(game.gamesPlayed)).c_str());
+    Screen.WriteLine(("Human Wins: " + to_string(game.humanWins)).c_str());
+    Screen.WriteLine(("CPU Wins: " + to_string(game.cpuWins)).c_str());
+    Screen.WriteLine(("Touch latency: " + latencySummary()).c_str());
+    // viewing the statistics also saves the flight log, so a kiosk operator can grab it after odd behaviour
+    Screen.WriteLine(("Boot to menu: " + to_string(bootToMenuMs) + " ms").c_str());
+    Screen.WriteLine(("Frame overruns: " + to_string(watchdog.overruns) +
+                      (watchdog.overruns ? " (worst " + to_string(watchdog.worstMs) + " ms, " + PHASE_NAMES[watchdog.worstPhase] + ")" : "")).c_str());
+    Screen.WriteLine(flightDump("request") ? "Flight log saved." : "Flight log: no storage.");
     SleepMs(2500);
 }
 
@@ -832,10 +5334,10 @@ void showStatistics(Game &game)
 */
 void showCredits()
 {
-    LCD.Clear(BLACK);
-    LCD.SetFontColor(WHITE);
-    LCD.WriteLine("Credits:");
-    LCD.WriteLine("Project by Aadit Bhatia and Pranav Rajesh");
+    Screen.Clear(BLACK);
+    Screen.SetFontColor(WHITE);
+    Screen.WriteLine("Credits:");
+    Screen.WriteLine("Project by Aadit Bhatia and Pranav Rajesh");
     SleepMs(2500);
 }
 
@@ -848,14 +5350,14 @@ void showCredits()
 */
 void DrawMainMenuButtons()
 {
-    LCD.Clear(BLACK);
-    LCD.SetFontColor(WHITE);
-    LCD.WriteAt("Menu", BTN_X, 10);
+    Screen.Clear(BLACK);
+    Screen.SetFontColor(WHITE);
+    Screen.WriteAt("Menu", BTN_X, 10);
     DrawMenuButton("1. Play", 0);
     DrawMenuButton("2. Instructions", 1);
     DrawMenuButton("3. Statistics", 2);
     DrawMenuButton("4. Credits", 3);
-    LCD.Update();
+    Screen.Update();
 }
 
 /*
@@ -867,14 +5369,20 @@ void DrawMainMenuButtons()
 */
 void mainMenuLoop(Game &game)
 {
+    PhaseScope phase(PHASE_MENU);
     bool running = true;
     while (running)
     {
         DrawMainMenuButtons();
+        if (!game.startupDone) {
+            // menu is on screen: finish the deferred init before the first touch is read
+            startupMenuShown();
+            game.finishStartup();
+        }
         int choice = GetMenuButtonPressed();
         if (choice == 0) continue;
         HighlightMenuButton(choice - 1);
-        LCD.Clear(BLACK);
+        Screen.Clear(BLACK);
         switch (choice)
         {
             case 1: { // Play: show difficulty submenu, then start matches
@@ -884,12 +5392,12 @@ void mainMenuLoop(Game &game)
                 int sx, sy;
                 WaitForCleanPress(sx, sy);
                 // easy box: x 30..150, y 50..90
-                if (sx >= 30 && sx <= 150 && sy >= 50 && sy <= 90) { game.difficulty = 0; LCD.Clear(BLACK); LCD.WriteLine("Difficulty: EASY"); SleepMs(800); }
+                if (sx >= 30 && sx <= 150 && sy >= 50 && sy <= 90) { game.difficulty = 0; Screen.Clear(BLACK); Screen.WriteLine("Difficulty: EASY"); SleepMs(800); }
                 // hard box
-                else if (sx >= 170 && sx <= 290 && sy >= 50 && sy <= 90) { game.difficulty = 1; LCD.Clear(BLACK); LCD.WriteLine("Difficulty: HARD"); SleepMs(800); }
+                else if (sx >= 170 && sx <= 290 && sy >= 50 && sy <= 90) { game.difficulty = 1; Screen.Clear(BLACK); Screen.WriteLine("Difficulty: HARD"); SleepMs(800); }
                 // start match box
-                else if (sx >= 30 && sx <= 290 && sy >= 110 && sy <= 150) { LCD.Clear(BLACK); LCD.WriteLine("Starting match..."); SleepMs(600); }
-                else { LCD.Clear(BLACK); LCD.WriteLine("No selection, starting default (Easy)."); game.difficulty = 0; SleepMs(700); }
+                else if (sx >= 30 && sx <= 290 && sy >= 110 && sy <= 150) { Screen.Clear(BLACK); Screen.WriteLine("Starting match..."); SleepMs(600); }
+                else { Screen.Clear(BLACK); Screen.WriteLine("No selection, starting default (Easy)."); game.difficulty = 0; SleepMs(700); }
 
                 // assign players & pokemon
                 game.assignPlayers();
@@ -901,12 +5409,12 @@ void mainMenuLoop(Game &game)
                     if (again) {
                         // reset both mons HP
                         game.p1.pkmn.reset(); game.p2.pkmn.reset();
-                        LCD.Clear(BLACK); LCD.WriteLine("Restarting match..."); SleepMs(700);
+                        Screen.Clear(BLACK); Screen.WriteLine("Restarting match..."); SleepMs(700);
                     }
                 }
                 // return to menu
-                LCD.Clear(BLACK);
-                LCD.WriteLine("Returning to menu...");
+                Screen.Clear(BLACK);
+                Screen.WriteLine("Returning to menu...");
                 SleepMs(500);
                 break;
             }
@@ -926,17 +5434,81 @@ void mainMenuLoop(Game &game)
 // ----------------------------- MAIN ENTRY POINT -----------------------------
 int main(void)
 {
-    std::srand((unsigned)std::time(nullptr));
-    LCD.Clear(BLACK);
-    LCD.SetFontColor(WHITE);
+    startupMark("main");
+#if defined(__unix__) || defined(__APPLE__)
+    flightInstallFaultHandlers();
+#endif
+#ifdef MINIMON_PROFILE
+    profileStart();
+#endif
+#ifdef MINIMON_FUZZ
+    {
+        Game fuzzGame;
+        fuzzGame.finishStartup();
+        return runFuzzer(fuzzGame, FUZZ_CASES);
+    }
+#endif
+#ifdef MINIMON_BALANCE
+    {
+        Game balanceGame;
+        balanceGame.loadBank();
+        return runBalance(balanceGame);
+    }
+#endif
+#ifdef MINIMON_SIM
+    {
+        Game simGame;
+        simGame.finishStartup();
+        return runSimulator(simGame, (int)sysconf(_SC_NPROCESSORS_ONLN), SIM_MATCHES_PER_WORKER);
+    }
+#endif
+#ifdef MINIMON_BENCH
+    {
+        Game benchGame;
+        benchGame.finishStartup();
+        return runBenchmarks(benchGame);
+    }
+#endif
+#ifdef MINIMON_VIEWER
+    {
+        Game viewGame;
+        viewGame.finishStartup();
+        return runViewer(viewGame);
+    }
+#endif
+#ifdef MINIMON_BROADCAST
+    broadcast.start();
+    atexit(broadcastShutdown);
+#endif
+    Screen.Clear(BLACK);
+    Screen.SetFontColor(WHITE);
+
+#if defined(MINIMON_AUTOMATION)
+    // scripted UI session: fixed seed and no checkpoint, so every run takes the same path
+    if (!loadUiScript("ui_script.txt")) { printf("ui_script.txt missing or invalid\n"); return 1; }
+    Game game;
+    seedRandom(1);
+#else
+#ifdef MINIMON_VIRTUAL_CLOCK
+    // touches for the whole session come from a script (see loadTouchScript), MINIMON_TOUCH_SCRIPT picks another one
+    const char *script = getenv("MINIMON_TOUCH_SCRIPT");
+    if (!script) script = "touch_script.txt";
+    if (!loadTouchScript(script)) printf("no %s, running without touches\n", script);
+#endif
 
     Game game;
+    // resume the previous session if one was checkpointed, otherwise start a fresh random stream
+    // (done in finishStartup, once the menu is showing)
+    game.resumeSession = true;
+#endif
 
     // Main menu loop (option D: menu controls whole app). Exits on Credits->Exit or similar.
     mainMenuLoop(game);
 
-    // Never reached normally; but pause
-    while (true) SleepMs(1000);
+    // Never reached normally; park on a blank screen and wake up only once a minute
+    Screen.Clear(BLACK);
+    Screen.Update();
+    while (true) IdleSleep(PARKED_TICK_MS);
     return 0;
 }
 